@@ -0,0 +1,88 @@
+#!/bin/bash
+
+###############################################################################
+# Network Fault Test for ESP32 India Table Project
+#
+# Usage: ./fault-test.sh <BROKER> [SECONDS] [EFFECT]
+# Example: ./fault-test.sh 192.168.2.10 30 rainbow
+#
+# Starts EFFECT on the table, then runs each network fault scenario for
+# SECONDS: no fault (baseline), WiFi drop, broker outage, 200 ms network
+# latency and 30% MQTT message loss. For each one the table reports the
+# frame-interval distribution (p50/p90/p99/max and frames over 100 ms),
+# which is printed here so runs can be compared between firmware versions.
+# Needs mosquitto_pub and mosquitto_sub (mosquitto-clients package).
+###############################################################################
+
+# Color codes for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+TOPIC_CMD="IndiaTable-cmd"
+TOPIC_LOG="IndiaTable-log"
+
+# Scenarios run in order (kind[,value] - see the fault command)
+SCENARIOS=(none wifi mqtt latency,200 loss,30)
+
+# Time allowed after each scenario for WiFi/MQTT to reconnect and the report to arrive
+SETTLE_SECONDS=25
+
+# Check if broker argument is provided
+if [ -z "$1" ]; then
+    echo -e "${RED}ERROR: No MQTT broker provided${NC}"
+    echo ""
+    echo "Usage: $0 <BROKER> [SECONDS] [EFFECT]"
+    echo "Example: $0 192.168.2.10 30 rainbow"
+    exit 1
+fi
+
+for tool in mosquitto_pub mosquitto_sub; do
+    if ! command -v "$tool" > /dev/null; then
+        echo -e "${RED}ERROR: $tool not found - install the mosquitto clients${NC}"
+        exit 1
+    fi
+done
+
+BROKER=$1
+SECONDS_PER_SCENARIO=${2:-30}
+EFFECT=${3:-rainbow}
+
+# Collect the table's log output while the test runs
+LOG_FILE=$(mktemp)
+mosquitto_sub -h "$BROKER" -t "$TOPIC_LOG" > "$LOG_FILE" &
+SUB_PID=$!
+trap 'kill $SUB_PID 2> /dev/null; rm -f "$LOG_FILE"' EXIT
+sleep 1
+
+echo -e "${GREEN}╔════════════════════════════════════════════╗${NC}"
+echo -e "${GREEN}║  ESP32 India Table Network Fault Test     ║${NC}"
+echo -e "${GREEN}╚════════════════════════════════════════════╝${NC}"
+echo ""
+echo -e "${YELLOW}Broker:${NC} $BROKER"
+echo -e "${YELLOW}Effect:${NC} $EFFECT"
+echo -e "${YELLOW}Scenarios:${NC} ${SCENARIOS[*]}, $SECONDS_PER_SCENARIO s each"
+echo ""
+
+mosquitto_pub -h "$BROKER" -t "$TOPIC_CMD" -m "$EFFECT"
+sleep 2
+
+for scenario in "${SCENARIOS[@]}"; do
+    kind=${scenario%%,*}
+    value=""
+    if [ "$kind" != "$scenario" ]; then
+        value=",${scenario#*,}"
+    fi
+    echo -e "${YELLOW}Running $scenario...${NC}"
+    mosquitto_pub -h "$BROKER" -t "$TOPIC_CMD" -m "fault:$kind,$SECONDS_PER_SCENARIO$value"
+    sleep $((SECONDS_PER_SCENARIO + SETTLE_SECONDS))
+done
+
+echo ""
+if grep -q "\[Fault\]" "$LOG_FILE"; then
+    grep "\[Fault\]" "$LOG_FILE"
+else
+    echo -e "${RED}No fault reports on $TOPIC_LOG - is the table connected to $BROKER?${NC}"
+    exit 1
+fi
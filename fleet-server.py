@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+
+###############################################################################
+# Fleet Update Server for ESP32 India Table Project
+#
+# Usage: ./fleet-server.py <FIRMWARE> [--port 8000] [--group-limit 2]
+#                          [--broker BROKER] [--group all]
+# Example: ./fleet-server.py .pio/build/esp32dev-ota/firmware.bin.gz \
+#              --broker 192.168.2.21
+#
+# Serves one firmware image (plain or gzip) to tables that were sent a
+# pullUpdate command, signed with an HMAC-SHA256 keyed with the OTA
+# password. At most --group-limit tables per fleet group download and run
+# their health check at once; the others are told to retry later. A table
+# holds its slot until it reports its health check, so the rollout moves
+# on in waves. If a table in a group rolls back, the rest of that group is
+# refused. With --broker the pullUpdate command is published for you
+# (needs mosquitto_pub). Press Ctrl-C to stop; a summary is printed.
+###############################################################################
+
+import argparse
+import hashlib
+import hmac
+import os
+import socket
+import subprocess
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+# Color codes for output
+RED = "\033[0;31m"
+GREEN = "\033[0;32m"
+YELLOW = "\033[1;33m"
+NC = "\033[0m"  # No Color
+
+TOPIC_CMD = "IndiaTable-cmd"
+DEFAULT_KEY = "ChristmasTree2025!"
+
+
+class Fleet:
+    """Rollout state shared by the request handler threads."""
+
+    def __init__(self, group_limit, slot_timeout):
+        self.group_limit = group_limit
+        self.slot_timeout = slot_timeout
+        self.lock = threading.Lock()
+        self.active = {}      # group -> {id: time the download started}
+        self.halted = set()   # groups with a rolled back table
+        self.results = {}     # id -> (group, ok, reason, version, seconds)
+        self.started = {}     # id -> time the download started
+
+    def claim(self, group, table):
+        """Take a download slot in a group. Returns None or the reason for refusing."""
+        with self.lock:
+            if group in self.halted:
+                return "halted"
+            slots = self.active.setdefault(group, {})
+            now = time.time()
+            for other, since in list(slots.items()):
+                if now - since > self.slot_timeout:
+                    log(YELLOW, f"{other} ({group}) never reported - slot released")
+                    del slots[other]
+            if table not in slots and len(slots) >= self.group_limit:
+                return "busy"
+            slots[table] = now
+            self.started[table] = now
+            return None
+
+    def report(self, group, table, ok, reason, version):
+        """Record a health check result and release the table's slot."""
+        with self.lock:
+            self.active.get(group, {}).pop(table, None)
+            seconds = time.time() - self.started.get(table, time.time())
+            self.results[table] = (group, ok, reason, version, seconds)
+            if not ok:
+                self.halted.add(group)
+        return seconds
+
+
+def log(color, message):
+    print(f"{color}[{time.strftime('%H:%M:%S')}]{NC} {message}", flush=True)
+
+
+def make_handler(fleet, image, signature):
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            url = urlparse(self.path)
+            query = {k: v[0] for k, v in parse_qs(url.query).items()}
+            table = query.get("id", self.client_address[0])
+            group = query.get("group", "default")
+
+            if url.path == "/firmware":
+                refused = fleet.claim(group, table)
+                if refused == "busy":
+                    self.send_response(503)
+                    self.send_header("Retry-After", "15")
+                    self.end_headers()
+                    return
+                if refused == "halted":
+                    log(RED, f"{table} ({group}) refused - a table in this group rolled back")
+                    self.send_error(403, "Rollout halted for this group")
+                    return
+                log(YELLOW, f"{table} ({group}) downloading {len(image)} bytes")
+                self.send_response(200)
+                self.send_header("Content-Type", "application/octet-stream")
+                self.send_header("Content-Length", str(len(image)))
+                self.send_header("X-Signature", signature)
+                self.end_headers()
+                self.wfile.write(image)
+            elif url.path == "/health":
+                ok = query.get("ok") == "1"
+                reason = query.get("reason", "")
+                version = query.get("version", "?")
+                seconds = fleet.report(group, table, ok, reason, version)
+                if ok:
+                    log(GREEN, f"{table} ({group}) healthy on v{version} after {seconds:.0f} s")
+                else:
+                    log(RED, f"{table} ({group}) rolled back ({reason}) - halting group {group}")
+                self.send_response(204)
+                self.end_headers()
+            else:
+                self.send_error(404)
+
+        def log_message(self, format, *args):
+            pass  # Rollout events are logged instead
+
+    return Handler
+
+
+def local_ip(broker):
+    """Address of this machine on the route to the broker."""
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+        s.connect((broker, 1883))
+        return s.getsockname()[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serve a signed firmware image to the India Table fleet")
+    parser.add_argument("firmware", help="firmware.bin or firmware.bin.gz")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--group-limit", type=int, default=2, help="tables per group updating at once")
+    parser.add_argument("--slot-timeout", type=int, default=600, help="seconds before a silent table's slot is freed")
+    parser.add_argument("--key", default=os.environ.get("OTA_PASSWORD", DEFAULT_KEY), help="OTA password (signing key)")
+    parser.add_argument("--broker", help="publish the pullUpdate command to this MQTT broker")
+    parser.add_argument("--group", default="all", help="fleet group to notify (default all)")
+    args = parser.parse_args()
+
+    try:
+        with open(args.firmware, "rb") as f:
+            image = f.read()
+    except OSError as e:
+        print(f"{RED}ERROR: Cannot read {args.firmware}: {e.strerror}{NC}")
+        sys.exit(1)
+    signature = hmac.new(args.key.encode(), image, hashlib.sha256).hexdigest()
+
+    fleet = Fleet(args.group_limit, args.slot_timeout)
+    server = ThreadingHTTPServer(("", args.port), make_handler(fleet, image, signature))
+
+    print(f"{GREEN}╔════════════════════════════════════════════╗{NC}")
+    print(f"{GREEN}║  ESP32 India Table Fleet Update Server    ║{NC}")
+    print(f"{GREEN}╚════════════════════════════════════════════╝{NC}")
+    print()
+    print(f"{YELLOW}Image:{NC} {args.firmware} ({len(image) // 1024} KB)")
+    print(f"{YELLOW}Signature:{NC} {signature[:16]}...")
+    print(f"{YELLOW}Per group:{NC} {args.group_limit} at a time")
+    print()
+
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+
+    if args.broker:
+        url = f"http://{local_ip(args.broker)}:{args.port}/firmware"
+        command = f"pullUpdate:{args.group},{url}"
+        subprocess.run(["mosquitto_pub", "-h", args.broker, "-t", TOPIC_CMD, "-m", command], check=True)
+        log(YELLOW, f"Published {command}")
+    else:
+        log(YELLOW, f"Send 'pullUpdate:<group|all>,http://<this machine>:{args.port}/firmware' to {TOPIC_CMD}")
+
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        pass
+    server.shutdown()
+
+    print()
+    healthy = [t for t, r in fleet.results.items() if r[1]]
+    failed = [t for t, r in fleet.results.items() if not r[1]]
+    print(f"{GREEN}Healthy:{NC} {len(healthy)}  {RED}Rolled back:{NC} {len(failed)}")
+    for table in failed:
+        group, _, reason, _, _ = fleet.results[table]
+        print(f"  {table} ({group}): {reason}")
+    for group in sorted(fleet.halted):
+        print(f"{RED}Group {group} halted{NC}")
+
+
+if __name__ == "__main__":
+    main()
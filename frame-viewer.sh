@@ -0,0 +1,159 @@
+#!/bin/bash
+
+###############################################################################
+# Frame Viewer for ESP32 India Table Project
+#
+# Usage: ./frame-viewer.sh <IP_ADDRESS> <term|png|video> [FRAMES] [OUTPUT]
+# Example: ./frame-viewer.sh 192.168.2.100 term
+#          ./frame-viewer.sh 192.168.2.100 png 300 rainbow.png
+#          ./frame-viewer.sh 192.168.2.100 video 500 rainbow.mp4
+#
+# Reads the frames the running effect renders from /frame and shows them:
+#   term  - live truecolor strip in this terminal until Ctrl-C
+#   png   - FRAMES frames stacked into a time x pixel image, time going down
+#   video - FRAMES frames encoded as a video at the rate they were captured
+# Frames are sampled as fast as HTTP allows, so a fast effect shows
+# every second or third frame. Needs curl; png and video also need ffmpeg.
+###############################################################################
+
+# Color codes for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+VIDEO_HEIGHT=64   # Each frame is stretched to this many rows in the video
+
+# Check if IP address and mode arguments are provided
+if [ -z "$1" ] || [ -z "$2" ]; then
+    echo -e "${RED}ERROR: IP address and mode required${NC}"
+    echo ""
+    echo "Usage: $0 <IP_ADDRESS> <term|png|video> [FRAMES] [OUTPUT]"
+    echo "Example: $0 192.168.2.100 png 300 rainbow.png"
+    exit 1
+fi
+
+IP_ADDRESS=$1
+MODE=$2
+FRAMES=${3:-300}
+
+case "$MODE" in
+    term)  ;;
+    png)   OUTPUT=${4:-frames.png} ;;
+    video) OUTPUT=${4:-frames.mp4} ;;
+    *)
+        echo -e "${RED}ERROR: Unknown mode '$MODE' - use term, png or video${NC}"
+        exit 1
+        ;;
+esac
+
+if [ "$MODE" != "term" ] && ! command -v ffmpeg > /dev/null; then
+    echo -e "${RED}ERROR: ffmpeg not found - needed for $MODE output${NC}"
+    exit 1
+fi
+
+RAW=$(mktemp)
+HEADERS=$(mktemp)
+CAPTURE=$(mktemp)
+trap 'rm -f "$RAW" "$HEADERS" "$CAPTURE"; printf "\033[0m"' EXIT
+
+LAST_FRAME=""
+
+# Fetch /frame into $RAW and set FRAME_ID and LEDS from its headers
+fetch_frame() {
+    curl -s -f -m 5 -D "$HEADERS" -o "$RAW" "http://$IP_ADDRESS/frame" || return 1
+    FRAME_ID=$(tr -d '\r' < "$HEADERS" | awk 'tolower($1) == "x-frame:" { print $2 }')
+    LEDS=$(tr -d '\r' < "$HEADERS" | awk 'tolower($1) == "x-leds:" { print $2 }')
+}
+
+# Fetch until the table has shown a frame we do not have yet. A still
+# effect never shows a new frame, so after ~2 s the same one is taken again.
+next_frame() {
+    local tries=0
+    while true; do
+        fetch_frame || return 1
+        if [ "$FRAME_ID" != "$LAST_FRAME" ] || [ $tries -ge 100 ]; then
+            LAST_FRAME=$FRAME_ID
+            return 0
+        fi
+        tries=$((tries + 1))
+        sleep 0.02
+    done
+}
+
+# Draw $RAW as one line of coloured blocks, averaging LEDs down to the terminal width
+draw_terminal() {
+    local cols
+    cols=$(tput cols 2> /dev/null || echo 80)
+    od -An -v -tu1 "$RAW" | awk -v cols="$cols" '
+        { for (i = 1; i <= NF; i++) v[n++] = $i }
+        END {
+            leds = int(n / 3)
+            if (leds == 0) exit
+            w = (leds < cols) ? leds : cols
+            line = ""
+            for (c = 0; c < w; c++) {
+                a = int(c * leds / w)
+                b = int((c + 1) * leds / w)
+                if (b <= a) b = a + 1
+                r = g = bl = 0
+                for (i = a; i < b; i++) { r += v[3 * i]; g += v[3 * i + 1]; bl += v[3 * i + 2] }
+                k = b - a
+                line = line sprintf("\033[48;2;%d;%d;%dm ", r / k, g / k, bl / k)
+            }
+            printf "\r%s\033[0m", line
+        }'
+}
+
+echo -e "${GREEN}╔════════════════════════════════════════════╗${NC}"
+echo -e "${GREEN}║  ESP32 India Table Frame Viewer           ║${NC}"
+echo -e "${GREEN}╚════════════════════════════════════════════╝${NC}"
+echo ""
+echo -e "${YELLOW}Target IP:${NC} $IP_ADDRESS"
+
+if ! fetch_frame; then
+    echo -e "${RED}ERROR: No response from http://$IP_ADDRESS/frame${NC}"
+    exit 1
+fi
+echo -e "${YELLOW}Strip:${NC} $LEDS LEDs"
+echo ""
+
+if [ "$MODE" = "term" ]; then
+    echo "Press Ctrl-C to stop"
+    while next_frame; do
+        draw_terminal
+    done
+    echo ""
+    exit 0
+fi
+
+# Capture FRAMES frames for png or video
+echo -n "Capturing $FRAMES frames..."
+START_NS=$(date +%s%N)
+for ((i = 0; i < FRAMES; i++)); do
+    if ! next_frame; then
+        echo -e "\n${RED}ERROR: Lost contact with the table after $i frames${NC}"
+        exit 1
+    fi
+    cat "$RAW" >> "$CAPTURE"
+done
+END_NS=$(date +%s%N)
+ELAPSED_MS=$(( (END_NS - START_NS) / 1000000 ))
+FPS=$(awk "BEGIN { printf \"%.2f\", $FRAMES * 1000 / ($ELAPSED_MS > 0 ? $ELAPSED_MS : 1) }")
+echo " done in $ELAPSED_MS ms ($FPS frames/s)"
+
+if [ "$MODE" = "png" ]; then
+    ffmpeg -v error -y -f rawvideo -pix_fmt rgb24 -s "${LEDS}x${FRAMES}" -i "$CAPTURE" "$OUTPUT"
+else
+    # yuv420p needs an even width
+    WIDTH=$(( (LEDS + 1) / 2 * 2 ))
+    ffmpeg -v error -y -f rawvideo -pix_fmt rgb24 -s "${LEDS}x1" -r "$FPS" -i "$CAPTURE" \
+        -vf "scale=${WIDTH}:${VIDEO_HEIGHT}:flags=neighbor" -pix_fmt yuv420p "$OUTPUT"
+fi
+
+if [ $? -eq 0 ]; then
+    echo -e "${GREEN}✓ Wrote $OUTPUT${NC}"
+else
+    echo -e "${RED}ERROR: ffmpeg could not write $OUTPUT${NC}"
+    exit 1
+fi
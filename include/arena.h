@@ -0,0 +1,59 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Fixed-size bump allocator
+ * The backing block is claimed once with begin() and carved into 4-byte
+ * aligned pieces by alloc(). Pieces are never freed individually; reset()
+ * hands the whole block back in O(1).
+ */
+class Arena {
+public:
+  /**
+   * @brief Claim the backing memory from the heap
+   * @param bytes Total capacity of the arena
+   * @return true if the heap could supply the block
+   */
+  bool begin(size_t bytes) {
+    _base = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    _capacity = _base ? bytes : 0;
+    _used = 0;
+    return _base != NULL;
+  }
+
+  /**
+   * @brief Carve a zeroed block out of the arena
+   * @param bytes Size of the block
+   * @return Pointer to the block, or NULL if the arena is full
+   */
+  void* alloc(size_t bytes) {
+    size_t aligned = (bytes + 3) & ~((size_t)3);
+    if (_base == NULL || aligned > _capacity - _used) {
+      return NULL;
+    }
+    void* block = _base + _used;
+    _used += aligned;
+    memset(block, 0, aligned);
+    return block;
+  }
+
+  /**
+   * @brief Release every block at once
+   */
+  void reset() {
+    _used = 0;
+  }
+
+  size_t capacity() const { return _capacity; }
+  size_t used() const { return _used; }
+  size_t remaining() const { return _capacity - _used; }
+
+private:
+  uint8_t* _base = NULL;
+  size_t _capacity = 0;
+  size_t _used = 0;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,89 @@
+#ifndef EFFECT_RANDOM_H
+#define EFFECT_RANDOM_H
+
+#include <Arduino.h>
+
+#define EFFECT_RANDOM_BUFFER 16  // Random bytes generated per refill
+
+/**
+ * @brief Seedable per-effect random generator
+ * A 32-bit xorshift fills a small buffer 16 bytes at a time and draws are
+ * served from the buffer. Bounded draws use Lemire's multiply-and-reject
+ * method, so every value in the range is equally likely. The same seed
+ * always gives the same sequence, so an effect can be replayed exactly.
+ */
+class EffectRandom {
+public:
+  /**
+   * @brief Restart the sequence from a seed
+   * @param seed Any value; 0 is mapped to a fixed non-zero seed
+   */
+  void seed(uint32_t seed) {
+    _state = seed ? seed : 0x9E3779B9UL;
+    _pos = EFFECT_RANDOM_BUFFER;
+  }
+
+  /**
+   * @brief Next random byte
+   */
+  uint8_t next8() {
+    if (_pos >= EFFECT_RANDOM_BUFFER) {
+      refill();
+    }
+    return _buffer[_pos++];
+  }
+
+  /**
+   * @brief Next random 16-bit value
+   */
+  uint16_t next16() {
+    uint8_t high = next8();
+    return (uint16_t)high << 8 | next8();
+  }
+
+  /**
+   * @brief Unbiased random value in [0, bound)
+   * @param bound Upper limit (exclusive); 0 returns 0
+   */
+  uint16_t below(uint16_t bound) {
+    uint32_t m = (uint32_t)next16() * bound;
+    uint16_t low = (uint16_t)m;
+    if (low < bound) {
+      uint16_t threshold = (uint16_t)(0x10000UL - bound) % bound;
+      while (low < threshold) {
+        m = (uint32_t)next16() * bound;
+        low = (uint16_t)m;
+      }
+    }
+    return m >> 16;
+  }
+
+  /**
+   * @brief Unbiased random value in [low, high)
+   */
+  uint16_t between(uint16_t low, uint16_t high) {
+    return low + below(high - low);
+  }
+
+private:
+  /**
+   * @brief Generate the next EFFECT_RANDOM_BUFFER bytes
+   */
+  void refill() {
+    uint32_t x = _state;
+    for (uint8_t i = 0; i < EFFECT_RANDOM_BUFFER; i += 4) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      memcpy(_buffer + i, &x, 4);
+    }
+    _state = x;
+    _pos = 0;
+  }
+
+  uint32_t _state = 0x9E3779B9UL;
+  uint8_t _buffer[EFFECT_RANDOM_BUFFER];
+  uint8_t _pos = EFFECT_RANDOM_BUFFER;
+};
+
+#endif // EFFECT_RANDOM_H
@@ -0,0 +1,43 @@
+#ifndef EFFECT_THREAD_H
+#define EFFECT_THREAD_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Resume point of a stackless effect thread
+ * An effect thread is a function written as straight-line steps that
+ * yields with EFFECT_NEXT_FRAME() or EFFECT_SLEEP_MS() and picks up at the
+ * same spot on its next call. Only this struct is kept between calls, so
+ * locals do not survive a yield - anything that must lives in the effect's
+ * frame struct next to the EffectThread. A zeroed EffectThread starts at
+ * the top.
+ *
+ * Each yield records its source line, so put at most one yield on a line,
+ * and do not yield from inside a switch statement.
+ */
+struct EffectThread {
+  uint16_t line;
+  unsigned long wakeMs;
+};
+
+// Start of the thread body
+#define EFFECT_BEGIN(t) switch ((t)->line) { case 0:
+
+// Return now and carry on from here on the next frame
+#define EFFECT_NEXT_FRAME(t) \
+  do { (t)->line = __LINE__; return; case __LINE__:; } while (0)
+
+// Return on every frame until ms milliseconds have passed
+#define EFFECT_SLEEP_MS(t, ms) \
+  do { \
+    (t)->wakeMs = millis() + (ms); \
+    (t)->line = __LINE__; \
+    __attribute__((fallthrough)); \
+    case __LINE__: \
+    if ((long)(millis() - (t)->wakeMs) < 0) return; \
+  } while (0)
+
+// End of the thread body - the next call starts again from the top
+#define EFFECT_END(t) } (t)->line = 0
+
+#endif // EFFECT_THREAD_H
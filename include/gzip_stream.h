@@ -0,0 +1,262 @@
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+#include <Arduino.h>
+#include <esp32/rom/miniz.h>
+#include <esp32/rom/crc.h>
+
+#define GZIP_TRAILER_BYTES 8        // CRC32 and length of the original data
+
+/**
+ * @brief Streaming gzip decoder on the inflater in the ESP32 ROM
+ * Compressed bytes go in with write() in chunks of any size and the
+ * decompressed bytes come out through a sink as soon as they are ready, so
+ * the whole file never has to fit in RAM. Only single-member gzip files
+ * (what the gzip tool writes) are handled. finish() checks the CRC32 and
+ * length in the gzip trailer against what was produced.
+ *
+ * Uses about 43 KB of heap between begin() and end(): the 32 KB window the
+ * format requires, plus the inflater state.
+ */
+class GzipStream {
+public:
+  // Receives decompressed data; return false to stop with an error
+  typedef bool (*Sink)(const uint8_t* data, size_t length);
+
+  /**
+   * @brief Allocate the window and inflater and expect a gzip header
+   * @param sink Where decompressed data is written
+   * @return true if the heap could supply the buffers
+   */
+  bool begin(Sink sink) {
+    end();
+    _window = (uint8_t*)heap_caps_malloc(TINFL_LZ_DICT_SIZE, MALLOC_CAP_8BIT);
+    _inflater = (tinfl_decompressor*)heap_caps_malloc(sizeof(tinfl_decompressor), MALLOC_CAP_8BIT);
+    if (_window == NULL || _inflater == NULL) {
+      end();
+      _error = "out of memory";
+      return false;
+    }
+    tinfl_init(_inflater);
+    _sink = sink;
+    _headerState = HEADER_FIXED;
+    _headerPos = 0;
+    _windowPos = 0;
+    _crc = 0;
+    _outputBytes = 0;
+    _inputBytes = 0;
+    _done = false;
+    _error = NULL;
+    return true;
+  }
+
+  /**
+   * @brief Release the buffers
+   */
+  void end() {
+    if (_window != NULL) {
+      heap_caps_free(_window);
+      _window = NULL;
+    }
+    if (_inflater != NULL) {
+      heap_caps_free(_inflater);
+      _inflater = NULL;
+    }
+  }
+
+  /**
+   * @brief Decompress the next chunk of the file
+   * @return false on a format error or if the sink refused data (see error())
+   */
+  bool write(const uint8_t* data, size_t length) {
+    if (_error != NULL || _inflater == NULL) {
+      return false;
+    }
+    rememberTail(data, length);
+    _inputBytes += length;
+
+    while (length > 0 && _headerState != HEADER_DONE) {
+      if (!parseHeader(*data++)) {
+        return false;
+      }
+      length--;
+    }
+
+    // Whatever follows the deflate data is the trailer, checked in finish()
+    while (!_done) {
+      size_t inBytes = length;
+      size_t outBytes = TINFL_LZ_DICT_SIZE - _windowPos;
+      tinfl_status status = tinfl_decompress(_inflater, data, &inBytes, _window,
+                                             _window + _windowPos, &outBytes,
+                                             TINFL_FLAG_HAS_MORE_INPUT);
+      data += inBytes;
+      length -= inBytes;
+      if (outBytes > 0) {
+        _crc = crc32_le(_crc, _window + _windowPos, outBytes);
+        _outputBytes += outBytes;
+        if (!_sink(_window + _windowPos, outBytes)) {
+          _error = "write failed";
+          return false;
+        }
+        _windowPos = (_windowPos + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+      }
+      if (status < TINFL_STATUS_DONE) {
+        _error = "corrupt deflate data";
+        return false;
+      }
+      if (status == TINFL_STATUS_DONE) {
+        _done = true;
+      } else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && length == 0) {
+        break;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Check the file is complete and matches its trailer
+   * @return true if all data was decompressed and the CRC32 and length match
+   */
+  bool finish() {
+    if (_error != NULL) {
+      return false;
+    }
+    if (!_done || _inputBytes < GZIP_TRAILER_BYTES) {
+      _error = "file is truncated";
+      return false;
+    }
+    uint32_t crc;
+    uint32_t size;
+    memcpy(&crc, _tail, 4);
+    memcpy(&size, _tail + 4, 4);
+    if (crc != _crc) {
+      _error = "CRC32 mismatch";
+      return false;
+    }
+    if (size != (uint32_t)_outputBytes) {
+      _error = "length mismatch";
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief True if data starts with the gzip magic bytes
+   */
+  static bool isGzip(const uint8_t* data, size_t length) {
+    return length >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+  }
+
+  const char* error() const { return _error; }
+  size_t inputBytes() const { return _inputBytes; }
+  size_t outputBytes() const { return _outputBytes; }
+
+private:
+  enum HeaderState : uint8_t {
+    HEADER_FIXED,       // ID1 ID2 CM FLG MTIME(4) XFL OS
+    HEADER_EXTRA_LEN,
+    HEADER_EXTRA,
+    HEADER_NAME,
+    HEADER_COMMENT,
+    HEADER_CRC,
+    HEADER_DONE
+  };
+  enum : uint8_t { FLAG_HCRC = 0x02, FLAG_EXTRA = 0x04, FLAG_NAME = 0x08, FLAG_COMMENT = 0x10 };
+
+  /**
+   * @brief Consume one header byte
+   */
+  bool parseHeader(uint8_t b) {
+    switch (_headerState) {
+      case HEADER_FIXED:
+        if ((_headerPos == 0 && b != 0x1f) || (_headerPos == 1 && b != 0x8b) ||
+            (_headerPos == 2 && b != 8)) {
+          _error = "not a gzip deflate file";
+          return false;
+        }
+        if (_headerPos == 3) {
+          _flags = b;
+        }
+        if (++_headerPos == 10) {
+          nextHeaderField(HEADER_EXTRA_LEN);
+        }
+        return true;
+      case HEADER_EXTRA_LEN:
+        _extraLength |= (uint16_t)b << (8 * _headerPos);
+        if (++_headerPos == 2) {
+          nextHeaderField(HEADER_EXTRA);
+        }
+        return true;
+      case HEADER_EXTRA:
+        if (++_headerPos >= _extraLength) {
+          nextHeaderField(HEADER_NAME);
+        }
+        return true;
+      case HEADER_NAME:
+        if (b == 0) {
+          nextHeaderField(HEADER_COMMENT);
+        }
+        return true;
+      case HEADER_COMMENT:
+        if (b == 0) {
+          nextHeaderField(HEADER_CRC);
+        }
+        return true;
+      case HEADER_CRC:
+        if (++_headerPos == 2) {
+          nextHeaderField(HEADER_DONE);
+        }
+        return true;
+      default:
+        return true;
+    }
+  }
+
+  /**
+   * @brief Move to the next header field, skipping those the flags say are absent
+   */
+  void nextHeaderField(HeaderState state) {
+    _headerPos = 0;
+    if (state == HEADER_EXTRA_LEN) {
+      _extraLength = 0;
+      if (!(_flags & FLAG_EXTRA)) state = HEADER_NAME;
+    }
+    if (state == HEADER_EXTRA && _extraLength == 0) state = HEADER_NAME;
+    if (state == HEADER_NAME && !(_flags & FLAG_NAME)) state = HEADER_COMMENT;
+    if (state == HEADER_COMMENT && !(_flags & FLAG_COMMENT)) state = HEADER_CRC;
+    if (state == HEADER_CRC && !(_flags & FLAG_HCRC)) state = HEADER_DONE;
+    _headerState = state;
+  }
+
+  /**
+   * @brief Keep the last GZIP_TRAILER_BYTES of input
+   * The inflater may read a few bytes past the end of the deflate data, so
+   * the trailer is taken from the end of the file rather than from what it
+   * leaves over.
+   */
+  void rememberTail(const uint8_t* data, size_t length) {
+    if (length >= GZIP_TRAILER_BYTES) {
+      memcpy(_tail, data + length - GZIP_TRAILER_BYTES, GZIP_TRAILER_BYTES);
+    } else {
+      memmove(_tail, _tail + length, GZIP_TRAILER_BYTES - length);
+      memcpy(_tail + GZIP_TRAILER_BYTES - length, data, length);
+    }
+  }
+
+  uint8_t* _window = NULL;
+  tinfl_decompressor* _inflater = NULL;
+  Sink _sink = NULL;
+  HeaderState _headerState = HEADER_FIXED;
+  uint8_t _flags = 0;
+  uint16_t _headerPos = 0;
+  uint16_t _extraLength = 0;
+  size_t _windowPos = 0;
+  uint32_t _crc = 0;
+  size_t _outputBytes = 0;
+  size_t _inputBytes = 0;
+  uint8_t _tail[GZIP_TRAILER_BYTES];
+  bool _done = false;
+  const char* _error = NULL;
+};
+
+#endif // GZIP_STREAM_H
@@ -0,0 +1,130 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <Arduino.h>
+
+#define NOISE_OCTAVES 3  // Octaves summed by NoiseField (coarsest first)
+
+/**
+ * @brief Hash a lattice point to a pseudo-random byte
+ */
+inline uint8_t noiseHash(uint16_t x, uint16_t y) {
+  uint32_t h = x * 0x27d4eb2dUL ^ y * 0x165667b1UL;
+  h ^= h >> 15;
+  h *= 0x85ebca6bUL;
+  h ^= h >> 13;
+  return h >> 24;
+}
+
+/**
+ * @brief Smoothstep easing of a 0-255 fraction, 3t^2 - 2t^3 in fixed point
+ */
+inline uint8_t noiseFade(uint8_t t) {
+  return ((uint32_t)t * t * (768 - 2 * t)) >> 16;
+}
+
+/**
+ * @brief Blend two bytes by a 0-255 fraction
+ */
+inline uint8_t noiseLerp(uint8_t a, uint8_t b, uint8_t t) {
+  return a + (((int)b - a) * t >> 8);
+}
+
+/**
+ * @brief Integer-only 1D value noise
+ * @param x Position in 8.8 fixed point (256 = one lattice cell)
+ * @return Smoothly varying value 0-255
+ */
+inline uint8_t valueNoise1D(uint32_t x) {
+  uint16_t cell = x >> 8;
+  uint8_t t = noiseFade(x & 0xFF);
+  return noiseLerp(noiseHash(cell, 0), noiseHash(cell + 1, 0), t);
+}
+
+/**
+ * @brief Integer-only 2D value noise
+ * @param x Position in 8.8 fixed point
+ * @param y Position in 8.8 fixed point
+ * @return Smoothly varying value 0-255
+ */
+inline uint8_t valueNoise2D(uint32_t x, uint32_t y) {
+  uint16_t cx = x >> 8;
+  uint16_t cy = y >> 8;
+  uint8_t tx = noiseFade(x & 0xFF);
+  uint8_t ty = noiseFade(y & 0xFF);
+  uint8_t top = noiseLerp(noiseHash(cx, cy), noiseHash(cx + 1, cy), tx);
+  uint8_t bottom = noiseLerp(noiseHash(cx, cy + 1), noiseHash(cx + 1, cy + 1), tx);
+  return noiseLerp(top, bottom, ty);
+}
+
+/**
+ * @brief Per-pixel fractal noise with cached, time-sliced octaves
+ * Each octave doubles the frequency of the one before and counts half as
+ * much. Coarse octaves change slowly, so they are refreshed for only a
+ * slice of the pixels each frame (1/4 for the coarsest, 1/2 for the middle
+ * one) and the cached samples fill in the rest. Only the finest octave is
+ * sampled for every pixel on every frame.
+ */
+class NoiseField {
+public:
+  /**
+   * @brief Attach the field to its cache
+   * @param cache Zeroed block of cacheBytes(count) bytes
+   * @param count Number of pixels
+   */
+  void begin(uint8_t* cache, int count) {
+    _layers = cache;
+    _values = cache + count * NOISE_OCTAVES;
+    _count = count;
+    _frame = 0;
+  }
+
+  /**
+   * @brief Bytes of cache a field of this many pixels needs
+   */
+  static size_t cacheBytes(int count) {
+    return count * (NOISE_OCTAVES + 1);
+  }
+
+  /**
+   * @brief Advance the field to a new time and recombine the octaves
+   * @param time Position along the time axis in 8.8 fixed point
+   * @param scale Distance between neighbouring pixels for the coarsest octave (8.8)
+   * @return Number of noise samples taken
+   */
+  int update(uint32_t time, uint16_t scale) {
+    int samples = 0;
+    for (int k = 0; k < NOISE_OCTAVES; k++) {
+      uint8_t* layer = _layers + k * _count;
+      int period = 1 << (NOISE_OCTAVES - 1 - k);
+      uint32_t t = (time << k) + ((uint32_t)k << 16);  // Offset keeps octaves uncorrelated
+      for (int i = _frame % period; i < _count; i += period) {
+        layer[i] = valueNoise2D(((uint32_t)i * scale) << k, t);
+        samples++;
+      }
+    }
+    _frame++;
+
+    // Weights 4:2:1, divided by 7
+    for (int i = 0; i < _count; i++) {
+      uint16_t sum = _layers[i] * 4 + _layers[_count + i] * 2 + _layers[2 * _count + i];
+      _values[i] = (sum * 73UL) >> 9;
+    }
+    return samples;
+  }
+
+  /**
+   * @brief Combined noise value of a pixel from the last update
+   */
+  uint8_t operator[](int i) const {
+    return _values[i];
+  }
+
+private:
+  uint8_t* _layers = NULL;  // NOISE_OCTAVES rows of cached samples
+  uint8_t* _values = NULL;  // Combined value per pixel
+  int _count = 0;
+  uint8_t _frame = 0;
+};
+
+#endif // NOISE_H
@@ -0,0 +1,86 @@
+#ifndef OUTPUT_STAGE_H
+#define OUTPUT_STAGE_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <math.h>
+
+// WS2812B power model, matching FastLED's power_mgt defaults (5V strip)
+#define OUTPUT_RED_MW 80    // mW for one LED's red channel at full scale
+#define OUTPUT_GREEN_MW 55  // mW for one LED's green channel at full scale
+#define OUTPUT_BLUE_MW 75   // mW for one LED's blue channel at full scale
+#define OUTPUT_DARK_MW 5    // mW for one LED with all channels off
+
+/**
+ * @brief Build the combined gamma and brightness lookup table
+ * Folding brightness into the gamma curve means the output pass costs one
+ * table lookup per channel no matter how many corrections are applied.
+ * @param lut 256-entry table to fill
+ * @param gammaX10 Gamma times ten (10 = linear, 22 = typical LED gamma)
+ * @param brightness Master brightness (0-255)
+ */
+inline void buildOutputLut(uint8_t* lut, uint8_t gammaX10, uint8_t brightness) {
+  float gamma = gammaX10 / 10.0f;
+  for (int v = 0; v < 256; v++) {
+    lut[v] = (uint8_t)(powf(v / 255.0f, gamma) * brightness + 0.5f);
+  }
+}
+
+/**
+ * @brief Fused output kernel - remap, gamma/brightness and colour order in one pass
+ * Writes wire[i] from src[remap[i]] and accumulates the per-channel totals
+ * the power limiter needs, so the frame is only walked once.
+ * @param src Render buffer (logical pixel order, RGB)
+ * @param wire Output buffer handed to FastLED (physical order, wire colour order)
+ * @param remap For each physical pixel, the logical pixel it shows
+ * @param lut Combined gamma/brightness table from buildOutputLut()
+ * @param count Number of pixels
+ * @param order Colour order of the strip
+ * @param channelSums Receives the summed red, green and blue output values
+ */
+inline void fusedOutput(const CRGB* src, CRGB* wire, const uint16_t* remap, const uint8_t* lut,
+                        int count, EOrder order, uint32_t channelSums[3]) {
+  const uint8_t byte0 = (order >> 6) & 0x3;
+  const uint8_t byte1 = (order >> 3) & 0x3;
+  const uint8_t byte2 = order & 0x3;
+  uint32_t red = 0;
+  uint32_t green = 0;
+  uint32_t blue = 0;
+
+  for (int i = 0; i < count; i++) {
+    const CRGB& pixel = src[remap[i]];
+    uint8_t c[3] = {lut[pixel.r], lut[pixel.g], lut[pixel.b]};
+    red += c[0];
+    green += c[1];
+    blue += c[2];
+    wire[i].raw[0] = c[byte0];
+    wire[i].raw[1] = c[byte1];
+    wire[i].raw[2] = c[byte2];
+  }
+
+  channelSums[0] = red;
+  channelSums[1] = green;
+  channelSums[2] = blue;
+}
+
+/**
+ * @brief Scale needed to keep a frame inside the power budget
+ * @param channelSums Per-channel totals from fusedOutput()
+ * @param count Number of pixels
+ * @param budget_mW Power budget in milliwatts
+ * @return 255 when the frame fits, otherwise the scale that brings it to budget
+ */
+inline uint8_t outputPowerScale(const uint32_t channelSums[3], int count, uint32_t budget_mW) {
+  uint32_t dark_mW = (uint32_t)count * OUTPUT_DARK_MW;
+  uint32_t lit_mW = (channelSums[0] * OUTPUT_RED_MW + channelSums[1] * OUTPUT_GREEN_MW +
+                     channelSums[2] * OUTPUT_BLUE_MW) / 255;
+  if (dark_mW + lit_mW <= budget_mW) {
+    return 255;
+  }
+  if (budget_mW <= dark_mW) {
+    return 0;
+  }
+  return (uint8_t)((uint64_t)(budget_mW - dark_mW) * 255 / lit_mW);
+}
+
+#endif // OUTPUT_STAGE_H
@@ -0,0 +1,47 @@
+#ifndef RENDER_SCALE_H
+#define RENDER_SCALE_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/**
+ * @brief How many strip pixels each rendered pixel covers
+ * @param renderPixels Resolution the effect asked for (0 = full resolution)
+ * @param count Number of LEDs on the strip
+ * @return Divisor of at least 1, chosen so the effect never renders more
+ *         than renderPixels pixels however long the strip gets
+ */
+inline int renderDivisor(int renderPixels, int count) {
+  if (renderPixels <= 0 || renderPixels >= count) {
+    return 1;
+  }
+  return (count + renderPixels - 1) / renderPixels;
+}
+
+/**
+ * @brief Stretch a low resolution frame over the strip with linear interpolation
+ * Source pixel k lands on strip pixel k * divisor; the pixels in between are
+ * blended from their two neighbours. Pixels past the last source pixel hold
+ * its colour.
+ * @param src Low resolution frame
+ * @param srcCount Number of pixels in src
+ * @param dst Strip buffer to fill
+ * @param dstCount Number of pixels in dst
+ * @param divisor Strip pixels per source pixel
+ */
+inline void upscaleLinear(const CRGB* src, int srcCount, CRGB* dst, int dstCount, int divisor) {
+  const uint16_t step = 256 / divisor;
+  int i = 0;
+  for (int k = 0; k < srcCount && i < dstCount; k++) {
+    const CRGB& a = src[k];
+    const CRGB& b = src[k + 1 < srcCount ? k + 1 : k];
+    uint16_t frac = 0;
+    for (int j = 0; j < divisor && i < dstCount; j++, i++, frac += step) {
+      dst[i].r = a.r + (((int)b.r - a.r) * frac >> 8);
+      dst[i].g = a.g + (((int)b.g - a.g) * frac >> 8);
+      dst[i].b = a.b + (((int)b.b - a.b) * frac >> 8);
+    }
+  }
+}
+
+#endif // RENDER_SCALE_H
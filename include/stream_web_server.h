@@ -0,0 +1,31 @@
+#ifndef STREAM_WEB_SERVER_H
+#define STREAM_WEB_SERVER_H
+
+#include <WebServer.h>
+#include <WiFi.h>
+
+/**
+ * @brief WebServer whose handlers can keep a request's connection for themselves
+ * When a handler returns with the client still connected, handleClient()
+ * waits up to HTTP_MAX_CLOSE_WAIT (2 s) for it to close and accepts no
+ * other client meanwhile. A handler that streams on after returning, like
+ * an event stream, takes the connection with takeClient() so the server is
+ * free for the next request at once.
+ */
+class StreamWebServer : public WebServer {
+public:
+  StreamWebServer(int port) : WebServer(port) {}
+
+  /**
+   * @brief Take over the current request's connection
+   * The server forgets the client, so it neither waits on nor closes it.
+   * @return The connection; the caller closes it when done
+   */
+  WiFiClient takeClient() {
+    WiFiClient taken = _currentClient;
+    _currentClient = WiFiClient();
+    return taken;
+  }
+};
+
+#endif
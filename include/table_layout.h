@@ -0,0 +1,114 @@
+#ifndef TABLE_LAYOUT_H
+#define TABLE_LAYOUT_H
+
+#include <Arduino.h>
+#include <math.h>
+
+// Table edges in clockwise order, starting at the top-left corner
+enum TableSide : uint8_t {
+  SIDE_TOP,
+  SIDE_RIGHT,
+  SIDE_BOTTOM,
+  SIDE_LEFT
+};
+
+// Table corners, numbered so that corner N is where side N starts clockwise
+enum TableCorner : uint8_t {
+  CORNER_TOP_LEFT,
+  CORNER_TOP_RIGHT,
+  CORNER_BOTTOM_RIGHT,
+  CORNER_BOTTOM_LEFT
+};
+
+/**
+ * @brief How the strip is laid around the table
+ * sides[] holds the LED count of each edge in the order the strip visits
+ * them, starting at startCorner. An edge may have 0 LEDs.
+ */
+struct TableLayout {
+  uint16_t sides[4];
+  uint8_t startCorner;
+  bool clockwise;
+};
+
+/**
+ * @brief Precomputed position of one pixel on the table
+ * x/y span 0-255 along the longer table dimension (origin top-left),
+ * angle is 0-255 around the table centre starting east and turning
+ * clockwise, and side is the TableSide the pixel sits on.
+ */
+struct PixelCoord {
+  uint8_t x;
+  uint8_t y;
+  uint8_t angle;
+  uint8_t side;
+};
+
+/**
+ * @brief Total number of LEDs described by a layout
+ */
+inline int layoutLedCount(const TableLayout& layout) {
+  return layout.sides[0] + layout.sides[1] + layout.sides[2] + layout.sides[3];
+}
+
+/**
+ * @brief Compile a layout into the per-pixel coordinate table
+ * This is the only place trig is done; effects read the results.
+ * @param layout Table description
+ * @param map Output table, one entry per LED
+ * @param count Number of entries in map (pixels past the layout are left at the centre)
+ */
+inline void buildPixelMap(const TableLayout& layout, PixelCoord* map, int count) {
+  // Physical edge lengths indexed by TableSide
+  uint16_t edge[4];
+  for (int k = 0; k < 4; k++) {
+    int side = layout.clockwise ? (layout.startCorner + k) % 4
+                                : (layout.startCorner + 7 - k) % 4;
+    edge[side] = layout.sides[k];
+  }
+
+  float width = max(edge[SIDE_TOP], edge[SIDE_BOTTOM]);
+  float height = max(edge[SIDE_LEFT], edge[SIDE_RIGHT]);
+  if (width < 1) width = 1;
+  if (height < 1) height = 1;
+
+  // Corner positions in clockwise order: TL, TR, BR, BL
+  const float cornerX[4] = {0, width, width, 0};
+  const float cornerY[4] = {0, 0, height, height};
+
+  // Scale so the longer dimension spans 0-255, centring the shorter one
+  float scale = 255.0f / max(width, height);
+  float offsetX = (255.0f - width * scale) / 2;
+  float offsetY = (255.0f - height * scale) / 2;
+
+  int index = 0;
+  for (int k = 0; k < 4; k++) {
+    int side = layout.clockwise ? (layout.startCorner + k) % 4
+                                : (layout.startCorner + 7 - k) % 4;
+    // Clockwise an edge runs from its own corner to the next one
+    int from = layout.clockwise ? side : (side + 1) % 4;
+    int to = layout.clockwise ? (side + 1) % 4 : side;
+
+    for (int j = 0; j < layout.sides[k] && index < count; j++, index++) {
+      float t = (j + 0.5f) / layout.sides[k];
+      float px = cornerX[from] + (cornerX[to] - cornerX[from]) * t;
+      float py = cornerY[from] + (cornerY[to] - cornerY[from]) * t;
+      float theta = atan2f(py - height / 2, px - width / 2);
+      if (theta < 0) theta += 2 * PI;
+
+      map[index].x = (uint8_t)(px * scale + offsetX + 0.5f);
+      map[index].y = (uint8_t)(py * scale + offsetY + 0.5f);
+      map[index].angle = (uint8_t)(theta * 256.0f / (2 * PI));
+      map[index].side = side;
+    }
+  }
+
+  for (; index < count; index++) {
+    map[index].x = 128;
+    map[index].y = 128;
+    map[index].angle = 0;
+    map[index].side = SIDE_TOP;
+  }
+}
+
+#endif // TABLE_LAYOUT_H
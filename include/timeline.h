@@ -0,0 +1,80 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/**
+ * @brief One scene of a multi-scene effect
+ * fadeMs dips the scene in from black at its start and out to black at its
+ * end (0 = hard cut). param is handed to the renderer through sceneParam.
+ */
+struct Scene {
+  void (*render)(CRGB* strip, int count);
+  uint16_t durationMs;
+  uint16_t fadeMs;
+  uint8_t param;
+};
+
+/**
+ * @brief A looping list of scenes
+ */
+struct Timeline {
+  const Scene* scenes;
+  uint8_t count;
+  uint32_t totalMs;
+};
+
+// Build a Timeline from a constant scene array
+#define TIMELINE(scenes) { scenes, sizeof(scenes) / sizeof(scenes[0]), timelineLength(scenes, sizeof(scenes) / sizeof(scenes[0])) }
+
+/**
+ * @brief Where a timeline is at a given moment
+ */
+struct TimelinePosition {
+  const Scene* scene;
+  uint32_t sceneMs;   // Time since the scene started
+  uint8_t level;      // Transition brightness, 255 outside a fade
+};
+
+/**
+ * @brief Total length of a scene list in milliseconds
+ */
+inline uint32_t timelineLength(const Scene* scenes, uint8_t count) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    total += scenes[i].durationMs;
+  }
+  return total;
+}
+
+/**
+ * @brief Evaluate a timeline from the clock
+ * Depends only on the elapsed time, so the result is the same however many
+ * frames were drawn or dropped before it.
+ * @param timeline Scene list
+ * @param elapsedMs Time since the effect started
+ */
+inline TimelinePosition timelineAt(const Timeline& timeline, uint32_t elapsedMs) {
+  TimelinePosition pos;
+  uint32_t t = timeline.totalMs ? elapsedMs % timeline.totalMs : 0;
+  uint8_t i = 0;
+  while (i + 1 < timeline.count && t >= timeline.scenes[i].durationMs) {
+    t -= timeline.scenes[i].durationMs;
+    i++;
+  }
+
+  const Scene& scene = timeline.scenes[i];
+  pos.scene = &scene;
+  pos.sceneMs = t;
+  pos.level = 255;
+  if (scene.fadeMs > 0) {
+    uint32_t edge = min(t, (uint32_t)scene.durationMs - t);
+    if (edge < scene.fadeMs) {
+      pos.level = edge * 255 / scene.fadeMs;
+    }
+  }
+  return pos;
+}
+
+#endif // TIMELINE_H
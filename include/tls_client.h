@@ -0,0 +1,409 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+
+#define TLS_CONNECT_TIMEOUT_MS 5000     // TCP connect
+#define TLS_HANDSHAKE_TIMEOUT_MS 15000
+#define TLS_WRITE_TIMEOUT_MS 5000
+
+/**
+ * @brief TLS client that resumes its last session on reconnect
+ * A drop-in Client for PubSubClient on top of mbedTLS. After a handshake
+ * the negotiated session (session ID and ticket) is kept, and the next
+ * connect offers it. If the server still knows it, the handshake skips the
+ * certificate chain and key exchange, which is most of its time and heap.
+ * If not, mbedTLS falls back to a full handshake by itself.
+ *
+ * The time and heap of the last handshake are kept for the caller. The
+ * heap figures are what the connection holds afterwards and the deepest
+ * dip during the handshake, sampled on each record sent or received.
+ */
+class TlsClient : public Client {
+public:
+  TlsClient() {
+    mbedtls_ssl_session_init(&_session);
+  }
+
+  ~TlsClient() {
+    stop();
+    mbedtls_ssl_session_free(&_session);
+    if (_configured) {
+      mbedtls_ssl_config_free(&_conf);
+      mbedtls_x509_crt_free(&_ca);
+      mbedtls_ctr_drbg_free(&_drbg);
+      mbedtls_entropy_free(&_entropy);
+    }
+  }
+
+  /**
+   * @brief Set the CA certificate the server's chain must lead to
+   * Call before the first connect. Without one the server is not
+   * authenticated (encryption only).
+   * @param pem CA certificate in PEM format
+   */
+  void setCACert(const char* pem) {
+    _caPem = pem;
+  }
+
+  /**
+   * @brief Ask the server for records of at most this size
+   * @param code MBEDTLS_SSL_MAX_FRAG_LEN_512 ... _4096, or _NONE
+   */
+  void setMaxFragment(uint8_t code) {
+    _maxFragment = code;
+  }
+
+  /**
+   * @brief Drop the saved session, so the next connect does a full handshake
+   */
+  void forgetSession() {
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_session_init(&_session);
+    _haveSession = false;
+  }
+
+  int connect(IPAddress ip, uint16_t port) override {
+    return connect(ip, port, NULL);
+  }
+
+  int connect(const char* host, uint16_t port) override {
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip)) {
+      _error = MBEDTLS_ERR_NET_UNKNOWN_HOST;
+      return 0;
+    }
+    return connect(ip, port, host);
+  }
+
+  size_t write(uint8_t b) override {
+    return write(&b, 1);
+  }
+
+  size_t write(const uint8_t* buf, size_t size) override {
+    if (!_connected) {
+      return 0;
+    }
+    size_t sent = 0;
+    unsigned long start = millis();
+    while (sent < size) {
+      int ret = mbedtls_ssl_write(&_ssl, buf + sent, size - sent);
+      if (ret > 0) {
+        sent += ret;
+      } else if ((ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ) &&
+                 millis() - start < TLS_WRITE_TIMEOUT_MS) {
+        vTaskDelay(1);
+      } else {
+        fail(ret);
+        break;
+      }
+    }
+    return sent;
+  }
+
+  int available() override {
+    if (!_connected) {
+      return 0;
+    }
+    int avail = mbedtls_ssl_get_bytes_avail(&_ssl);
+    if (avail == 0) {
+      // A zero-length read processes whatever record has arrived
+      int ret = mbedtls_ssl_read(&_ssl, NULL, 0);
+      if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        fail(ret);
+        return 0;
+      }
+      avail = mbedtls_ssl_get_bytes_avail(&_ssl);
+    }
+    return avail + (_peeked >= 0 ? 1 : 0);
+  }
+
+  int read() override {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+
+  int read(uint8_t* buf, size_t size) override {
+    if (size == 0) {
+      return 0;
+    }
+    if (_peeked >= 0) {
+      buf[0] = (uint8_t)_peeked;
+      _peeked = -1;
+      return 1;
+    }
+    if (!available()) {
+      return -1;
+    }
+    int ret = mbedtls_ssl_read(&_ssl, buf, size);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      fail(ret);
+    }
+    return ret > 0 ? ret : -1;
+  }
+
+  int peek() override {
+    if (_peeked < 0) {
+      _peeked = read();
+    }
+    return _peeked;
+  }
+
+  void flush() override {}
+
+  void stop() override {
+    if (_socket >= 0) {
+      if (_connected) {
+        mbedtls_ssl_close_notify(&_ssl);
+      }
+      close(_socket);
+      _socket = -1;
+    }
+    if (_sslReady) {
+      mbedtls_ssl_free(&_ssl);
+      _sslReady = false;
+    }
+    _connected = false;
+    _peeked = -1;
+  }
+
+  uint8_t connected() override {
+    return _connected;
+  }
+
+  operator bool() override {
+    return _connected;
+  }
+
+  // Last handshake
+  bool lastResumed() const { return _resumed; }
+  unsigned long lastHandshakeMs() const { return _handshakeMs; }
+  size_t lastHeapHeld() const { return _heapHeld; }
+  size_t lastHeapPeak() const { return _heapPeak; }
+  int lastError() const { return _error; }
+
+private:
+  /**
+   * @brief Connect the socket and run the handshake
+   * @param host Server name for SNI and certificate checks (NULL = none)
+   */
+  int connect(IPAddress ip, uint16_t port, const char* host) {
+    stop();
+    _error = 0;
+    if (!configure()) {
+      return 0;
+    }
+    size_t heapBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    _heapLow = heapBefore;
+    unsigned long start = millis();
+
+    if (!openSocket(ip, port)) {
+      return 0;
+    }
+    mbedtls_ssl_init(&_ssl);
+    _sslReady = true;
+    int ret = mbedtls_ssl_setup(&_ssl, &_conf);
+    if (ret == 0 && host != NULL) {
+      ret = mbedtls_ssl_set_hostname(&_ssl, host);
+    }
+    if (ret == 0 && _haveSession) {
+      ret = mbedtls_ssl_set_session(&_ssl, &_session);
+    }
+    if (ret != 0) {
+      fail(ret);
+      return 0;
+    }
+    mbedtls_ssl_set_bio(&_ssl, this, sendCallback, receiveCallback, NULL);
+
+    // Step through the handshake to see which way it went: a resumed
+    // handshake goes from ServerHello straight to ChangeCipherSpec and
+    // never reaches the server certificate state
+    bool full = false;
+    while (_ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+      ret = mbedtls_ssl_handshake_step(&_ssl);
+      if (_ssl.state == MBEDTLS_SSL_SERVER_CERTIFICATE) {
+        full = true;
+      }
+      if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        if (millis() - start > TLS_HANDSHAKE_TIMEOUT_MS) {
+          fail(MBEDTLS_ERR_SSL_TIMEOUT);
+          return 0;
+        }
+        vTaskDelay(1);
+      } else if (ret != 0) {
+        fail(ret);
+        forgetSession();
+        return 0;
+      }
+    }
+
+    _handshakeMs = millis() - start;
+    _resumed = _haveSession && !full;
+    size_t heapAfter = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    _heapHeld = heapBefore > heapAfter ? heapBefore - heapAfter : 0;
+    _heapPeak = heapBefore > _heapLow ? heapBefore - _heapLow : 0;
+
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_session_init(&_session);
+    _haveSession = mbedtls_ssl_get_session(&_ssl, &_session) == 0;
+    _connected = true;
+    return 1;
+  }
+
+  /**
+   * @brief Set up the random generator, CA and TLS settings on first use
+   */
+  bool configure() {
+    if (_configured) {
+      return true;
+    }
+    mbedtls_entropy_init(&_entropy);
+    mbedtls_ctr_drbg_init(&_drbg);
+    mbedtls_x509_crt_init(&_ca);
+    mbedtls_ssl_config_init(&_conf);
+    _configured = true;
+
+    int ret = mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy, NULL, 0);
+    if (ret == 0) {
+      ret = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                        MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0 && _caPem != NULL) {
+      ret = mbedtls_x509_crt_parse(&_ca, (const unsigned char*)_caPem, strlen(_caPem) + 1);
+    }
+    if (ret != 0) {
+      _error = ret;
+      mbedtls_ssl_config_free(&_conf);
+      mbedtls_x509_crt_free(&_ca);
+      mbedtls_ctr_drbg_free(&_drbg);
+      mbedtls_entropy_free(&_entropy);
+      _configured = false;
+      return false;
+    }
+    mbedtls_ssl_conf_rng(&_conf, mbedtls_ctr_drbg_random, &_drbg);
+    if (_caPem != NULL) {
+      mbedtls_ssl_conf_ca_chain(&_conf, &_ca, NULL);
+      mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    } else {
+      mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_NONE);
+    }
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    mbedtls_ssl_conf_max_frag_len(&_conf, _maxFragment);
+#endif
+    return true;
+  }
+
+  /**
+   * @brief Open a non-blocking TCP connection
+   */
+  bool openSocket(IPAddress ip, uint16_t port) {
+    _socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (_socket < 0) {
+      _error = MBEDTLS_ERR_NET_SOCKET_FAILED;
+      return false;
+    }
+    fcntl(_socket, F_SETFL, fcntl(_socket, F_GETFL, 0) | O_NONBLOCK);
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = (uint32_t)ip;
+    int ret = ::connect(_socket, (sockaddr*)&address, sizeof(address));
+    if (ret < 0 && errno == EINPROGRESS) {
+      fd_set writable;
+      FD_ZERO(&writable);
+      FD_SET(_socket, &writable);
+      timeval timeout = {TLS_CONNECT_TIMEOUT_MS / 1000, (TLS_CONNECT_TIMEOUT_MS % 1000) * 1000};
+      int error = 0;
+      socklen_t length = sizeof(error);
+      if (select(_socket + 1, NULL, &writable, NULL, &timeout) > 0 &&
+          getsockopt(_socket, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+        ret = 0;
+      }
+    }
+    if (ret < 0) {
+      _error = MBEDTLS_ERR_NET_CONNECT_FAILED;
+      stop();
+      return false;
+    }
+    int one = 1;
+    setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return true;
+  }
+
+  /**
+   * @brief Close the connection after an error
+   */
+  void fail(int error) {
+    _error = error;
+    _connected = false;
+    stop();
+  }
+
+  /**
+   * @brief Note the lowest free heap seen during the handshake
+   */
+  void sampleHeap() {
+    if (!_connected) {
+      size_t free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+      if (free < _heapLow) {
+        _heapLow = free;
+      }
+    }
+  }
+
+  static int sendCallback(void* context, const unsigned char* buf, size_t length) {
+    TlsClient* self = (TlsClient*)context;
+    self->sampleHeap();
+    int n = send(self->_socket, buf, length, MSG_DONTWAIT);
+    if (n < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+    return n;
+  }
+
+  static int receiveCallback(void* context, unsigned char* buf, size_t length) {
+    TlsClient* self = (TlsClient*)context;
+    self->sampleHeap();
+    int n = recv(self->_socket, buf, length, MSG_DONTWAIT);
+    if (n < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+    return n == 0 ? MBEDTLS_ERR_NET_CONN_RESET : n;
+  }
+
+  mbedtls_ssl_context _ssl;
+  mbedtls_ssl_config _conf;
+  mbedtls_ssl_session _session;
+  mbedtls_entropy_context _entropy;
+  mbedtls_ctr_drbg_context _drbg;
+  mbedtls_x509_crt _ca;
+  const char* _caPem = NULL;
+  uint8_t _maxFragment = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+  bool _configured = false;
+  bool _sslReady = false;
+  bool _haveSession = false;
+  bool _connected = false;
+  int _socket = -1;
+  int _peeked = -1;
+  int _error = 0;
+  bool _resumed = false;
+  unsigned long _handshakeMs = 0;
+  size_t _heapHeld = 0;
+  size_t _heapPeak = 0;
+  size_t _heapLow = 0;
+};
+
+#endif // TLS_CLIENT_H
@@ -0,0 +1,90 @@
+#!/bin/bash
+
+###############################################################################
+# MQTT Command Load Test for ESP32 India Table Project
+#
+# Usage: ./mqtt-load-test.sh <BROKER> [COMMANDS] [INTERVAL_MS]
+# Example: ./mqtt-load-test.sh 192.168.2.10 500 0
+#
+# Fires a burst of effect commands at the table over MQTT and prints the
+# throughput, drop and latency figures the table reports with commandStats.
+# INTERVAL_MS is the gap between commands (0 = as fast as the broker takes
+# them). Needs mosquitto_pub and mosquitto_sub (mosquitto-clients package).
+###############################################################################
+
+# Color codes for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+TOPIC_CMD="IndiaTable-cmd"
+TOPIC_LOG="IndiaTable-log"
+
+# Effects cycled through by the burst
+EFFECTS=(rainbow candyCane sweep sides christmas halloween serene twinkle)
+
+# Check if broker argument is provided
+if [ -z "$1" ]; then
+    echo -e "${RED}ERROR: No MQTT broker provided${NC}"
+    echo ""
+    echo "Usage: $0 <BROKER> [COMMANDS] [INTERVAL_MS]"
+    echo "Example: $0 192.168.2.10 500 0"
+    exit 1
+fi
+
+for tool in mosquitto_pub mosquitto_sub; do
+    if ! command -v "$tool" > /dev/null; then
+        echo -e "${RED}ERROR: $tool not found - install the mosquitto clients${NC}"
+        exit 1
+    fi
+done
+
+BROKER=$1
+COMMANDS=${2:-200}
+INTERVAL_MS=${3:-0}
+
+# Collect the table's log output while the test runs
+LOG_FILE=$(mktemp)
+mosquitto_sub -h "$BROKER" -t "$TOPIC_LOG" > "$LOG_FILE" &
+SUB_PID=$!
+trap 'kill $SUB_PID 2> /dev/null; rm -f "$LOG_FILE"' EXIT
+sleep 1
+
+echo -e "${GREEN}╔════════════════════════════════════════════╗${NC}"
+echo -e "${GREEN}║  ESP32 India Table MQTT Load Test         ║${NC}"
+echo -e "${GREEN}╚════════════════════════════════════════════╝${NC}"
+echo ""
+echo -e "${YELLOW}Broker:${NC} $BROKER"
+echo -e "${YELLOW}Commands:${NC} $COMMANDS, ${INTERVAL_MS} ms apart"
+echo ""
+
+# Start a fresh measurement window on the table
+mosquitto_pub -h "$BROKER" -t "$TOPIC_CMD" -m "commandStats"
+sleep 2
+: > "$LOG_FILE"
+
+# Fire the burst over one broker connection (one message per line)
+START_NS=$(date +%s%N)
+for ((i = 0; i < COMMANDS; i++)); do
+    echo "${EFFECTS[$((i % ${#EFFECTS[@]}))]}"
+    if [ "$INTERVAL_MS" -gt 0 ]; then
+        sleep "$(awk "BEGIN { print $INTERVAL_MS / 1000 }")"
+    fi
+done | mosquitto_pub -h "$BROKER" -t "$TOPIC_CMD" -l
+END_NS=$(date +%s%N)
+SENT_MS=$(( (END_NS - START_NS) / 1000000 ))
+echo "Sent $COMMANDS commands in $SENT_MS ms"
+
+# Let the table drain, then ask for its figures
+sleep 2
+mosquitto_pub -h "$BROKER" -t "$TOPIC_CMD" -m "commandStats"
+sleep 2
+
+echo ""
+if grep -q "\[Commands\]" "$LOG_FILE"; then
+    grep "\[Commands\]" "$LOG_FILE"
+else
+    echo -e "${RED}No commandStats reply on $TOPIC_LOG - is the table connected to $BROKER?${NC}"
+    exit 1
+fi
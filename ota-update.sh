@@ -3,11 +3,14 @@
 ###############################################################################
 # OTA Update Script for ESP32 India Table Project
 # 
-# Usage: ./ota-update.sh <IP_ADDRESS>
+# Usage: ./ota-update.sh <IP_ADDRESS> [--gzip]
 # Example: ./ota-update.sh 192.168.2.100
+#          ./ota-update.sh 192.168.2.100 --gzip
 #
 # This script performs an Over-The-Air firmware update to the ESP32 device
-# using PlatformIO.
+# using PlatformIO. With --gzip the image is compressed and uploaded over
+# HTTP (port 8080), and the device decompresses it as it arrives. Either
+# way the bytes sent and the upload time are printed for comparison.
 ###############################################################################
 
 # Color codes for output
@@ -16,6 +19,10 @@ GREEN='\033[0;32m'
 YELLOW='\033[1;33m'
 NC='\033[0m' # No Color
 
+OTA_PASSWORD="ChristmasTree2025!"
+OTA_HTTP_PORT=8080
+FIRMWARE=".pio/build/esp32dev-ota/firmware.bin"
+
 # Function to validate IP address format
 validate_ip() {
     local ip=$1
@@ -41,7 +48,7 @@ validate_ip() {
 if [ -z "$1" ]; then
     echo -e "${RED}ERROR: No IP address provided${NC}"
     echo ""
-    echo "Usage: $0 <IP_ADDRESS>"
+    echo "Usage: $0 <IP_ADDRESS> [--gzip]"
     echo "Example: $0 192.168.2.100"
     echo ""
     echo "To find your ESP32's IP address, check the serial monitor output"
@@ -50,6 +57,13 @@ if [ -z "$1" ]; then
 fi
 
 IP_ADDRESS=$1
+GZIP=0
+if [ "$2" = "--gzip" ]; then
+    GZIP=1
+elif [ -n "$2" ]; then
+    echo -e "${RED}ERROR: Unknown option: $2${NC}"
+    exit 1
+fi
 
 # Validate IP address format
 if ! validate_ip "$IP_ADDRESS"; then
@@ -65,16 +79,49 @@ echo -e "${GREEN}║  ESP32 India Table OTA Update             ║${NC}"
 echo -e "${GREEN}╚════════════════════════════════════════════╝${NC}"
 echo ""
 echo -e "${YELLOW}Target IP:${NC} $IP_ADDRESS"
-echo -e "${YELLOW}Password:${NC} ChristmasTree2025!"
+echo -e "${YELLOW}Password:${NC} $OTA_PASSWORD"
+if [ $GZIP -eq 1 ]; then
+    echo -e "${YELLOW}Transfer:${NC} gzip over HTTP"
+else
+    echo -e "${YELLOW}Transfer:${NC} espota"
+fi
 echo ""
-echo "Starting OTA update..."
+echo "Building firmware..."
 echo ""
 
 platformio run --target clean
-platformio run -e esp32dev-ota -t upload --upload-port "$IP_ADDRESS"
+if ! platformio run -e esp32dev-ota; then
+    echo -e "${RED}ERROR: Build failed${NC}"
+    exit 1
+fi
+IMAGE_BYTES=$(stat -c%s "$FIRMWARE" 2> /dev/null || stat -f%z "$FIRMWARE")
+
+echo ""
+echo "Starting OTA update..."
+echo ""
+
+if [ $GZIP -eq 1 ]; then
+    GZ_FIRMWARE="$FIRMWARE.gz"
+    gzip -9 -n -c "$FIRMWARE" > "$GZ_FIRMWARE"
+    SENT_BYTES=$(stat -c%s "$GZ_FIRMWARE" 2> /dev/null || stat -f%z "$GZ_FIRMWARE")
+    START_NS=$(date +%s%N)
+    curl -s -f -u "admin:$OTA_PASSWORD" -F "firmware=@$GZ_FIRMWARE" \
+        "http://$IP_ADDRESS:$OTA_HTTP_PORT/update?size=$SENT_BYTES"
+else
+    SENT_BYTES=$IMAGE_BYTES
+    START_NS=$(date +%s%N)
+    platformio run -e esp32dev-ota -t upload --upload-port "$IP_ADDRESS"
+fi
+RESULT=$?
+END_NS=$(date +%s%N)
+ELAPSED_MS=$(( (END_NS - START_NS) / 1000000 ))
+
+echo ""
+echo -e "${YELLOW}Image:${NC} $((IMAGE_BYTES / 1024)) KB"
+echo -e "${YELLOW}Sent:${NC} $((SENT_BYTES / 1024)) KB ($((SENT_BYTES * 100 / IMAGE_BYTES))% of the image) in $((ELAPSED_MS / 1000)).$(( (ELAPSED_MS / 100) % 10 )) s"
 
 # Check the exit status
-if [ $? -eq 0 ]; then
+if [ $RESULT -eq 0 ]; then
     echo ""
     echo -e "${GREEN}╔════════════════════════════════════════════╗${NC}"
     echo -e "${GREEN}║  ✓ OTA Update Successful!                 ║${NC}"
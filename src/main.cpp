@@ -10,23 +10,197 @@
 #include <ArduinoOTA.h>
 #include <FastLED.h>
 #include <WebServer.h>
+#include <Update.h>
+#include <HTTPClient.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/md.h>
+#include <esp_system.h>
+#include <esp_partition.h>
+#include <esp_core_dump.h>
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <lwip/sockets.h>
 #include "secrets.h"
 #include "favicon.h"
+#include "arena.h"
+#include "table_layout.h"
+#include "output_stage.h"
+#include "render_scale.h"
+#include "noise.h"
+#include "timeline.h"
+#include "effect_thread.h"
+#include "effect_random.h"
+#include "gzip_stream.h"
+#include "tls_client.h"
+#include "stream_web_server.h"
 
 // Built-in LED pin (usually GPIO2 on ESP32 dev boards)
 #define LED_BUILTIN 2
 
 // WS2812B LED Strip Configuration
-#define LED_PIN 33
-#define NUM_LEDS 300
-#define LED_TYPE WS2812B
-#define COLOR_ORDER GRB
+// These are the defaults used until a geometry has been saved to NVS with
+// the setStrip command; the stored values are loaded once at boot.
+#define DEFAULT_LED_PIN 33
+#define DEFAULT_NUM_LEDS 300
+#define DEFAULT_LED_CHIPSET CHIPSET_WS2812B
+#define DEFAULT_COLOR_ORDER GRB
+#define MAX_LEDS 1200
+
+// Parallel outputs - the logical strip is split into equal segments, one per
+// data pin. FastLED's ESP32 RMT driver clocks all outputs out at the same time,
+// so a frame takes as long as one segment instead of the whole strip.
+// Build with -D FASTLED_ESP32_I2S to use the I2S parallel driver instead.
+#define MAX_LED_OUTPUTS 4
+
+// Supported LED chipsets (stored in NVS by index)
+enum LedChipset : uint8_t {
+  CHIPSET_WS2812B,
+  CHIPSET_WS2811,
+  CHIPSET_SK6812
+};
+const char* chipsetNames[] = {"WS2812B", "WS2811", "SK6812"};
+const char* cornerNames[] = {"tl", "tr", "br", "bl"};
+
+// GPIOs that can drive an output. FastLED takes the pin as a template
+// parameter, so each one here is compiled in once per chipset.
+const uint8_t supportedLedPins[] = {13, 14, 25, 26, 27, 32, 33};
+
+// Active strip geometry (loaded from NVS by loadStripConfig())
+int numLeds = DEFAULT_NUM_LEDS;
+uint8_t ledOutputs = 1;
+uint8_t ledOutputPins[MAX_LED_OUTPUTS] = {DEFAULT_LED_PIN, 32, 27, 26};
+uint8_t ledChipset = DEFAULT_LED_CHIPSET;
+EOrder ledColorOrder = DEFAULT_COLOR_ORDER;
 
 // Power management - limit current draw
 #define MAX_BRIGHTNESS 80  // Optimized for 5V 4A power supply (0-255)
+#define POWER_BUDGET_MW (5 * 3500)  // Limit to 3.5A @ 5V (safe margin on 4A supply)
+#define MAX_REMAP_RANGES 8          // Reversed strip segments kept in NVS
+
+// Frame buffers, carved once at boot from a heap arena sized for numLeds.
+// Effects draw into leds[] in logical order; showStrip() runs the fused
+// output stage (remap, gamma, brightness, colour order) into wireLeds[]
+// and FastLED transmits that unmodified.
+Arena frameArena;
+CRGB* leds = NULL;
+CRGB* wireLeds = NULL;
+uint16_t* outputRemap = NULL;     // Logical pixel shown by each physical pixel
+CRGB* lowResLeds = NULL;          // Render target for effects drawn below full resolution
+int renderStride = 1;             // Strip pixels per rendered pixel for the effect being drawn
+
+// Effect state lives in its own arena. Only one effect runs at a time, so
+// enabling an effect carves its state (and later any thread frames, particle
+// pools or tables it needs) from here, and clearAllEffects() hands the whole
+// arena back in O(1).
+#define EFFECT_ARENA_BYTES 1024
+Arena effectArena;
+
+// State every effect starts with; zeroed when the effect is enabled
+struct EffectState {
+  unsigned long startMs;     // When the effect was enabled (timeline clock)
+  unsigned long lastUpdate;  // When the effect last drew a frame
+  uint8_t phase;             // Animation phase tracker (hue, angle, on/off or offset for some effects)
+  EffectRandom rng;          // The effect's own random generator
+};
+EffectState* effectState = NULL;
+uint32_t effectSeed = 0;     // Seed for the next effect's generator (0 = fresh random seed)
+NoiseField noiseField;            // Shared fractal noise for the flicker and aurora effects
+uint8_t sceneParam = 0;           // Parameter of the timeline scene being drawn
+
+// Output stage settings
+uint8_t outputLut[256];           // Gamma curve with master brightness folded in
+uint8_t outputGammaX10 = 10;      // Gamma x10 (10 = linear, as before the LUT existed)
+uint8_t masterBrightness = MAX_BRIGHTNESS;
+uint8_t lastPowerScale = 255;     // Extra scale the power limiter applied to the last frame
+unsigned long lastOutputMicros = 0;
 
-// LED array
-CRGB leds[NUM_LEDS];
+// Table geometry - where each pixel sits around the table. Compiled once
+// into pixelMap[] (same arena) so spatial effects never do trig per frame.
+TableLayout tableLayout;
+PixelCoord* pixelMap = NULL;
+
+// Strip transmit timing (measured around every FastLED.show())
+unsigned long showCount = 0;
+unsigned long lastShowMicros = 0;
+unsigned long maxShowMicros = 0;
+unsigned long totalShowMicros = 0;
+
+// Load shedding - when loop() overruns the frame budget, effects step down
+// through quality levels and climb back once there is headroom again.
+//   0: full quality
+//   1: half the sparkles per frame
+//   2: also halve the resolution of upscaled effects
+//   3: also halve the frame rate
+#define FRAME_BUDGET_US 20000       // loop() must turn around inside the fastest effect interval
+#define SHED_CHECK_INTERVAL 1000    // How often the frame time is judged (ms)
+#define SHED_RECOVER_CHECKS 5       // Consecutive quiet checks before quality is restored
+#define MAX_QUALITY_LEVEL 3
+#define LOOP_IDLE_MS 2              // Idle time at the end of loop() for WiFi and the idle task
+uint8_t qualityLevel = 0;
+uint8_t quietChecks = 0;
+unsigned long avgLoopMicros = 0;    // Smoothed loop() work time
+unsigned long peakLoopMicros = 0;   // Worst loop() since the last check
+unsigned long lastShedCheck = 0;
+unsigned long shedEvents = 0;
+
+// Loop stall watchdog - loop() is split into stages and each one is timed.
+// A stage that holds the loop longer than LOOP_STALL_MS counts as a stall
+// against that stage and is published, so a blocking call shows up with
+// where it sits and how long it took.
+enum LoopStage : uint8_t {
+  STAGE_COMMAND,      // Run the pending command
+  STAGE_OTA,          // OTA progress and the update health check
+  STAGE_MQTT,         // MQTT reconnect and mqttClient.loop()
+  STAGE_WIFI,         // WiFi reconnect
+  STAGE_WEB,          // webServer.handleClient()
+  STAGE_HOUSEKEEPING, // Fault scenario, breadcrumbs, reset report
+  STAGE_RENDER,       // Effect render and strip transmit
+  LOOP_STAGE_COUNT
+};
+const char* const loopStageNames[LOOP_STAGE_COUNT] = {
+  "command", "ota", "mqtt", "wifi", "web", "housekeeping", "render"
+};
+#define LOOP_STALL_MS 100           // A stage running longer than this is a stall
+#define STALL_LOG_INTERVAL_MS 1000  // At most one stall published per second, the rest are counted
+struct LoopStageStats {
+  unsigned long passes;
+  unsigned long totalMicros;
+  unsigned long maxMicros;
+  unsigned long stalls;
+};
+LoopStageStats loopStageStats[LOOP_STAGE_COUNT];
+unsigned long loopStatsSince = 0;
+LoopStage currentStage = STAGE_COMMAND;
+unsigned long stageStartMicros = 0;
+LoopStage stallStage = STAGE_COMMAND;  // Longest stall since the last one was published
+unsigned long stallMicros = 0;      // 0 = nothing to publish
+unsigned long stallsSinceLog = 0;
+unsigned long lastStallLogMs = 0;
+
+// Crash report - a few facts kept in RTC memory, which survives a panic or
+// watchdog reset (but not a power cut), are published after the reboot
+// together with the backtrace from the core dump partition
+#if defined(CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH) && defined(CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF)
+#define CRASH_COREDUMP 1            // This build writes core dumps to flash
+#else
+#define CRASH_COREDUMP 0
+#endif
+#define BREADCRUMB_MAGIC 0x1DA7AB1EUL
+#define CRASH_REPORT_WAIT_MS 60000  // How long the report waits for MQTT before going to Serial only
+struct Breadcrumbs {
+  uint32_t magic;
+  uint32_t uptimeSec;
+  uint32_t freeHeap;
+  uint32_t minFreeHeap;
+  uint8_t qualityLevel;
+  uint8_t loopStage;                // Stage loop() was in
+  char command[24];                 // Last command run
+};
+RTC_NOINIT_ATTR Breadcrumbs breadcrumbs;
+Breadcrumbs lastBreadcrumbs;        // Copy from before this boot
+bool lastBreadcrumbsValid = false;
+esp_reset_reason_t lastResetReason = ESP_RST_UNKNOWN;
+bool resetReportPending = true;
 
 // Firmware version
 #define FIRMWARE_VERSION "8.0.6"
@@ -43,129 +217,365 @@ volatile bool mqttConnected = false;
 
 // LED strip blink control
 bool blinkEnabled = false;
-bool blinkState = false;
 unsigned long blinkSpeed = 500;  // Blink interval in milliseconds (default 500ms)
-unsigned long lastBlinkTime = 0;
 CRGB blinkColor = CRGB::Red;  // Current blink color
 
 // Twinkle effect control
 bool twinkleEnabled = false;
-unsigned long lastTwinkleUpdate = 0;
 const int TWINKLE_UPDATE_INTERVAL = 50;  // Update every 50ms for smooth effect
 const int TWINKLE_LEDS_PER_UPDATE = 5;   // Number of LEDs to update each cycle
 
 // Twinkle Plus effect control (more aggressive)
 bool twinklePlusEnabled = false;
-unsigned long lastTwinklePlusUpdate = 0;
 const int TWINKLEPLUS_UPDATE_INTERVAL = 30;  // Faster updates for aggressive effect
 const int TWINKLEPLUS_LEDS_PER_UPDATE = 15;  // More LEDs per update
 
 // Gold effect control
 bool goldEnabled = false;
-unsigned long lastGoldUpdate = 0;
 const int GOLD_UPDATE_INTERVAL = 30;  // Same as twinkle+ for matching twinkle rate
 const int GOLD_LEDS_PER_UPDATE = 15;  // Same as twinkle+
 
 // Vegas effect control
 bool vegasEnabled = false;
-unsigned long lastVegasUpdate = 0;
 const int VEGAS_UPDATE_INTERVAL = 30;    // Fast updates for wild effect
-uint8_t vegasHue = 0;                    // Rainbow hue tracker
 
 // Valentines effect control
 bool valentinesEnabled = false;
-unsigned long lastValentinesUpdate = 0;
 const int VALENTINES_UPDATE_INTERVAL = 40;  // Smooth romantic animation
-uint8_t valentinesPhase = 0;                // Animation phase tracker
 
 // St. Patrick's effect control
 bool stPatricksEnabled = false;
-unsigned long lastStPatricksUpdate = 0;
 const int STPATRICKS_UPDATE_INTERVAL = 45;  // Smooth Irish animation
-uint8_t stPatricksPhase = 0;                // Animation phase tracker
 
 // Halloween effect control
 bool halloweenEnabled = false;
-unsigned long lastHalloweenUpdate = 0;
 const int HALLOWEEN_UPDATE_INTERVAL = 35;   // Spooky animation timing
-uint8_t halloweenPhase = 0;                 // Animation phase tracker
 
 // Christmas effect control
 bool christmasEnabled = false;
-unsigned long lastChristmasUpdate = 0;
 const int CHRISTMAS_UPDATE_INTERVAL = 40;   // Festive animation timing
-uint8_t christmasPhase = 0;                 // Animation phase tracker
+const int CHRISTMAS_RENDER_PIXELS = 75;     // Smooth waves - render at most 75 pixels and upscale
 
 // Birthday effect control
 bool birthdayEnabled = false;
-unsigned long lastBirthdayUpdate = 0;
 const int BIRTHDAY_UPDATE_INTERVAL = 35;    // Party animation timing
-uint8_t birthdayPhase = 0;                  // Animation phase tracker
 
 // Wild Christmas effect control
 bool wildChristmasEnabled = false;
-unsigned long lastWildChristmasUpdate = 0;
 const int WILDCHRISTMAS_UPDATE_INTERVAL = 25;  // Fast chaotic timing
-uint8_t wildChristmasPhase = 0;                // Animation phase tracker
 
 // Christmas Basic effect control
 bool christmasBasicEnabled = false;
-unsigned long lastChristmasBasicUpdate = 0;
 const int CHRISTMASBASIC_UPDATE_INTERVAL = 50;  // Twinkle update timing
 
 // Christmas Train effect control
 bool christmasTrainEnabled = false;
-unsigned long lastChristmasTrainUpdate = 0;
 unsigned long christmasTrainSpeed = 100;        // Rotation speed in ms (adjustable)
-int christmasTrainOffset = 0;                   // Current rotation offset
 
 // Rainbow effect control
 bool rainbowEnabled = false;
-unsigned long lastRainbowUpdate = 0;
 const int RAINBOW_UPDATE_INTERVAL = 30;     // Smooth rainbow timing
-uint8_t rainbowPhase = 0;                   // Animation phase tracker
+const int RAINBOW_RENDER_PIXELS = 150;      // Smooth gradients - half resolution on 300 LEDs
 
 // May The 4th effect control (Star Wars Day)
 bool mayThe4thEnabled = false;
-unsigned long lastMayThe4thUpdate = 0;
 const int MAYTHE4TH_UPDATE_INTERVAL = 35;   // Epic space saga timing
-uint8_t mayThe4thPhase = 0;                 // Animation phase tracker
+
+// Lightsaber duel thread state
+struct DuelFrame {
+  EffectThread thread;
+  int16_t clash;    // Where the blades meet
+  int16_t target;   // Where the clash point is being pushed to
+  uint8_t blade;    // Length of each blade's glow
+  uint8_t flash;    // Half-width of the white flash at the clash point
+  uint8_t strikes;  // Strikes left before the blades retract
+};
+DuelFrame* duelFrame = NULL;
 
 // Canada Day effect control
 bool canadaDayEnabled = false;
-unsigned long lastCanadaDayUpdate = 0;
 const int CANADADAY_UPDATE_INTERVAL = 40;   // Proud Canadian timing
-uint8_t canadaDayPhase = 0;                 // Animation phase tracker
+
+// Firework burst thread state
+struct BurstFrame {
+  EffectThread thread;
+  int16_t center;   // Pixel the current burst is centred on
+  uint8_t radius;   // How far the burst has spread (0 = no burst showing)
+  bool red;         // Red or white burst
+};
+BurstFrame* burstFrame = NULL;
 
 // New Years effect control
 bool newYearsEnabled = false;
-unsigned long lastNewYearsUpdate = 0;
 const int NEWYEARS_UPDATE_INTERVAL = 35;    // Celebration timing
-uint8_t newYearsPhase = 0;                  // Animation phase tracker
 
 // Candy Cane effect control
 bool candyCaneEnabled = false;
-unsigned long lastCandyCaneUpdate = 0;
 const int CANDYCANE_UPDATE_INTERVAL = 40;   // Stripe animation timing
-uint8_t candyCanePhase = 0;                 // Animation phase tracker
+const int CANDYCANE_RENDER_PIXELS = 150;    // Stripes are 4+ pixels wide - half resolution
 
 // Serene effect control
 bool sereneEnabled = false;
-unsigned long lastSereneUpdate = 0;
 const int SERENE_UPDATE_INTERVAL = 40;      // ~25 FPS smooth animation
 
+// Radial sweep effect control (uses the table layout)
+bool sweepEnabled = false;
+const int SWEEP_UPDATE_INTERVAL = 30;       // Smooth rotation timing
+const int SWEEP_RENDER_PIXELS = 150;        // Soft beam - half resolution on 300 LEDs
+
+// Table sides effect control (uses the table layout)
+bool sidesEnabled = false;
+const int SIDES_UPDATE_INTERVAL = 40;       // Gentle colour drift
+const int SIDES_RENDER_PIXELS = 75;         // Slow ripples - render at most 75 pixels and upscale
+
 // Command queue to avoid watchdog issues in MQTT callback
 String pendingCommand = "";
 unsigned long pendingCommandParam = 0;
+String pendingCommandArg = "";  // Text parameter for commands like setStrip
 String unknownCommand = "";  // Track unknown commands for logging
 
-// MQTT client
+// Command throughput, reported and restarted by commandStats
+unsigned long commandStatsSince = 0;      // millis() when the window started
+unsigned long commandsReceived = 0;       // Commands that arrived over MQTT or the web
+unsigned long commandsExecuted = 0;       // Commands loop() ran
+unsigned long commandsDropped = 0;        // Replaced in the pending slot before loop() ran them
+unsigned long commandQueuedMicros = 0;    // When the pending command was queued
+unsigned long commandRunMicros = 0;       // Total queue-to-run latency
+unsigned long maxCommandRunMicros = 0;
+unsigned long awaitingFrameMicros = 0;    // Queue time of the last command, until a frame shows it
+unsigned long commandFrameCount = 0;
+unsigned long commandFrameMicros = 0;     // Total queue-to-frame latency
+unsigned long maxCommandFrameMicros = 0;
+
+// MQTT client - plain TCP, or TLS when built with -D MQTT_USE_TLS=1 (set
+// MQTT_PORT to the broker's TLS port and MQTT_CA_CERT in secrets.h). The
+// TLS client resumes its last session on reconnect, which skips the
+// certificate chain and key exchange; handshake time and heap are kept
+// for full and resumed connects separately and reported by showConfig.
+#ifndef MQTT_USE_TLS
+#define MQTT_USE_TLS 0
+#endif
+#if MQTT_USE_TLS
+#define MQTT_TLS_MAX_FRAGMENT MBEDTLS_SSL_MAX_FRAG_LEN_4096  // Largest record the broker may send
+TlsClient espClient;
+struct TlsHandshakeStats {
+  unsigned long count;
+  unsigned long totalMs;
+  unsigned long maxMs;
+  size_t heapHeld;                  // Held by the connection after the last handshake
+  size_t maxHeapPeak;               // Deepest dip during any handshake
+};
+TlsHandshakeStats tlsStats[2];      // [0] full, [1] resumed
+#else
 WiFiClient espClient;
+#endif
 PubSubClient mqttClient(espClient);
 String mqttClientId = "";
 
+// Persistent MQTT session - the table connects with cleanSession off and
+// subscribes at QoS 1, so the broker keeps commands published at QoS 1
+// while the table is offline and delivers them when it reconnects. A
+// command may carry an id ("@<id> <command>"); a second copy of an id seen
+// recently (a QoS 1 redelivery, or a publisher retrying) is dropped.
+#define MQTT_CMD_QOS 1
+#define MQTT_DEDUPE_IDS 16          // Recent message ids remembered
+#define MQTT_DEDUPE_ID_MAX 24
+#define MQTT_BACKLOG_WINDOW_MS 2000 // Commands arriving this soon after connecting were queued by the broker
+char mqttRecentIds[MQTT_DEDUPE_IDS][MQTT_DEDUPE_ID_MAX + 1];
+uint8_t mqttRecentIdNext = 0;
+unsigned long mqttConnectedAt = 0;
+unsigned long mqttOfflineSince = 0; // When the connection was lost
+unsigned long mqttOfflineMs = 0;    // Length of the last outage
+bool mqttSessionReportPending = false;
+unsigned long mqttBacklog = 0;      // Commands delivered from the session after the last connect
+unsigned long mqttReconnects = 0;   // Counted for commandStats
+unsigned long mqttSessionCommands = 0;
+unsigned long mqttDuplicates = 0;
+
+// Asset storage - LittleFS on the littlefs partition (see partitions.csv)
+#define FS_BENCH_FILE "/bench.tmp"
+#define FS_BENCH_BYTES 65536        // Size of the benchFs test file
+#define FS_BENCH_CHUNK 4096         // One erase block per write/read
+#define FS_READ_BUDGET_KBPS 100     // Asset reads must keep up with a 300-LED clip at 50 frames/s, twice over
+bool fsMounted = false;
+
 // Web Server on port 80
-WebServer webServer(80);
+StreamWebServer webServer(80);
+
+// Network task - OTA reception runs here on core 0 so an upload does not
+// stop loop() rendering on core 1. The OTA callbacks run in this task, so
+// they only set the volatile fields below; loop() does the logging.
+#define NETWORK_TASK_CORE 0
+#define NETWORK_TASK_STACK 8192
+#define NETWORK_TASK_POLL_MS 10     // Idle time between OTA polls
+#define OTA_SLICE_MS 20             // Longest the OTA transfer runs before yielding a tick
+#define OTA_BAR_PIXELS 30           // Progress bar over the first pixels of the strip
+#define OTA_BAR_LEVEL 96            // Brightness of the filled part of the bar
+TaskHandle_t networkTaskHandle = NULL;
+volatile bool otaActive = false;
+volatile bool otaFinished = false;  // Image written; loop() reports it and reboots
+volatile int otaError = -1;         // ota_error_t of a failed update, -1 = none
+volatile unsigned int otaProgress = 0;
+volatile unsigned int otaTotal = 0;
+volatile unsigned long otaStartMs = 0;
+volatile unsigned int otaWritten = 0;     // Image bytes written to flash
+const char* volatile otaErrorDetail = NULL;
+
+// HTTP firmware upload - POST a plain or gzip-compressed image to
+// http://<ip>:8080/update (handled in the network task alongside ArduinoOTA)
+#define OTA_HTTP_PORT 8080
+#define OTA_HTTP_USER "admin"               // Password is OTA_PASSWORD
+WebServer updateServer(OTA_HTTP_PORT);
+GzipStream otaGzip;
+volatile bool otaGzipped = false;
+bool updateRejected = false;                // Network task only
+bool updateFailed = false;
+volatile bool otaFromFleet = false;         // Image came from a pullUpdate
+volatile bool otaFilesystem = false;        // espota upload of a LittleFS image, not firmware
+
+// Fleet updates - pullUpdate makes the table fetch a signed image from a
+// local server (see fleet-server.py). The server limits how many tables in
+// a group update at once and answers 503 while the group is full.
+#define FLEET_GROUP_MAX 16
+#define PULL_URL_MAX 160
+#define PULL_RETRY_MS 15000         // Wait before asking a busy server again (plus up to 5 s jitter)
+#define PULL_MAX_ATTEMPTS 40
+#define PULL_READ_TIMEOUT_MS 10000
+#define HMAC_SHA256_BYTES 32
+char fleetGroup[FLEET_GROUP_MAX + 1] = "default";
+char pullUrl[PULL_URL_MAX];          // Set by loop() only while pullRequested is false
+volatile bool pullRequested = false;
+unsigned long pullRetryAt = 0;
+uint8_t pullAttempts = 0;
+
+// Health check after an update - the new image must reach MQTT and hold
+// its frame rate, or the previous image is booted again
+#define HEALTH_SETTLE_MS 30000      // Healthy for this long before the image is kept
+#define HEALTH_TIMEOUT_MS 180000    // Roll back if it has not passed by then
+#define HEALTH_MAX_BOOTS 3          // Boots allowed before the check passes
+bool healthCheckActive = false;
+unsigned long healthCheckStart = 0;
+unsigned long healthySince = 0;
+uint8_t healthQualityLimit = MAX_QUALITY_LEVEL - 1;  // Highest shedding level the new image may sit at
+char healthReportUrl[PULL_URL_MAX + 96];  // Result sent to the fleet server by the network task
+volatile bool healthReportPending = false;
+unsigned long otaSliceStart = 0;    // Network task only
+bool otaAnnounced = false;          // loop() has logged the start of the update
+uint8_t otaShownPercent = 0;
+unsigned long otaStartFrames = 0;
+uint8_t otaStartQuality = 0;        // Shedding level of the running image when the update started
+unsigned long fpsMarkMs = 0;        // Frame rate outside updates, for comparison
+unsigned long fpsMarkFrames = 0;
+unsigned long baselineFpsX10 = 0;
+
+// UDP command port - a controller on the LAN can send commands straight to
+// the table instead of through the broker. A packet is "<seq> <command> <mac>"
+// where mac is the HMAC-SHA256 of "<seq> <command>" keyed with OTA_PASSWORD,
+// in hex. seq must be higher than in the last packet accepted, so a captured
+// packet cannot be replayed. The network task checks packets and passes the
+// command to loop() through a FreeRTOS queue. It answers "ok <seq>" when a
+// command is accepted and "shown <seq> <us>" once the first frame after it
+// is on the strip, with the time since the packet arrived. A command that
+// turns out not to exist is answered "err unknown <seq>" instead of "shown".
+#define UDP_COMMAND_PORT 4210
+#define UDP_PACKET_MAX 160
+#define UDP_COMMAND_MAX 96
+#define UDP_QUEUE_LENGTH 4
+#define UDP_SEQ_RESERVE 10000000ULL // Seqs reserved in NVS per write - 10 s of udp-command.py's microsecond clock
+struct UdpCommand {
+  char text[UDP_COMMAND_MAX];
+  uint64_t seq;
+  uint32_t address;                 // Sender, for the "shown" reply (network byte order)
+  uint16_t port;
+  unsigned long receivedMicros;
+};
+int udpSocket = -1;
+QueueHandle_t udpQueue = NULL;
+uint64_t udpLastSeq = 0;            // Network task only
+uint64_t udpReservedSeq = 0;        // Saved in NVS; no seq above it is accepted until it is raised
+volatile unsigned long udpAccepted = 0;
+volatile unsigned long udpRejected = 0;   // Bad format or signature
+volatile unsigned long udpReplayed = 0;   // Sequence number not above the last one
+volatile unsigned long udpQueueFull = 0;
+bool pendingFromUdp = false;        // The pending command came in over UDP
+UdpCommand pendingUdp;
+bool awaitingFrameUdp = false;      // The command awaiting its frame came in over UDP
+UdpCommand awaitingUdp;
+UdpCommand shownUdp;                // Set by showStrip(), answered by the network task
+volatile bool shownUdpPending = false;
+unsigned long shownUdpMicros = 0;
+unsigned long udpFrameCount = 0;
+unsigned long udpFrameMicros = 0;   // Total packet-to-frame latency
+unsigned long maxUdpFrameMicros = 0;
+
+// Web handler timing, per route (reported by webStats and /stats)
+enum WebRoute : uint8_t {
+  WEB_ROUTE_ROOT,
+  WEB_ROUTE_CMD,
+  WEB_ROUTE_FAVICON,
+  WEB_ROUTE_FRAME,
+  WEB_ROUTE_EVENTS,
+  WEB_ROUTE_COUNT
+};
+const char* const webRouteNames[WEB_ROUTE_COUNT] = {"/", "/cmd", "/favicon.ico", "/frame", "/events"};
+#define WEB_LATENCY_BUCKETS 16      // Bucket b holds handler times below 32 << b us
+struct WebRouteStats {
+  unsigned long requests;
+  unsigned long totalMicros;
+  unsigned long maxMicros;
+  long heapDelta;                   // Net change in free heap across all requests
+  uint32_t buckets[WEB_LATENCY_BUCKETS];
+};
+WebRouteStats webStats[WEB_ROUTE_COUNT];
+unsigned long webStatsSince = 0;
+
+// Server-Sent Events - a browser opens /events once and the table pushes a
+// small state event whenever the effect, speeds or connectivity change.
+// The socket is kept here after the handler returns, so each open page
+// costs one idle connection instead of a stream of polling requests.
+#define SSE_MAX_CLIENTS 4
+#define SSE_CHECK_MS 250            // How often the state is compared with what was last sent
+#define SSE_HEARTBEAT_MS 15000      // Comment line sent on quiet streams so dead ones are found
+#define SSE_RETRY_MS 3000           // How long a browser waits before reopening a lost stream
+WiFiClient sseClients[SSE_MAX_CLIENTS];
+String sseLastState = "";
+unsigned long sseLastCheck = 0;
+unsigned long sseLastSend = 0;
+unsigned long sseEventsSent = 0;    // Counted for webStats
+unsigned long sseRefused = 0;
+String currentEffect = "off";       // Last command that replaced the running effect
+unsigned long effectChanges = 0;    // Bumped by clearAllEffects()
+
+// Network fault injection - a scenario breaks the network in one way for a
+// set time while the frame-interval histogram records how evenly frames
+// kept coming. The report is the regression figure for that scenario.
+enum FaultKind : uint8_t {
+  FAULT_NONE,         // Baseline, network left alone
+  FAULT_WIFI,         // Drop WiFi at the start (the reconnect blocks loop())
+  FAULT_MQTT,         // Broker unreachable for the whole scenario
+  FAULT_LATENCY,      // Stall every network pass by faultValue ms
+  FAULT_LOSS,         // Discard faultValue % of incoming MQTT messages
+  FAULT_KIND_COUNT
+};
+const char* const faultNames[FAULT_KIND_COUNT] = {"none", "wifi", "mqtt", "latency", "loss"};
+#define FAULT_UNREACHABLE_BROKER "192.0.2.1"  // TEST-NET-1, never answers
+#define FAULT_MAX_SECONDS 600
+#define FAULT_REPORT_WAIT_MS 20000  // How long the report waits for MQTT to come back
+#define FRAME_INTERVAL_BUCKETS 12   // Bucket b holds frame intervals below 4 << b ms
+#define FRAME_STALL_MS 100          // Intervals longer than this count as a visible stall
+FaultKind activeFault = FAULT_NONE;
+FaultKind faultScenario = FAULT_NONE;  // Last scenario started, named in its report
+unsigned long faultValue = 0;
+unsigned long faultStartMs = 0;
+unsigned long faultDurationMs = 0;  // 0 = no scenario running
+unsigned long faultEndMs = 0;
+bool faultReportPending = false;
+unsigned long faultDropped = 0;     // MQTT messages discarded by FAULT_LOSS
+unsigned long lastFrameMicros = 0;  // 0 = no frame yet in this scenario
+unsigned long frameIntervals = 0;
+unsigned long frameStalls = 0;
+unsigned long maxFrameIntervalMicros = 0;
+uint32_t frameIntervalBuckets[FRAME_INTERVAL_BUCKETS];
 
 /**
  * @brief Log message to both Serial console and MQTT broker
@@ -204,868 +614,2493 @@ void logMessageF(const char* format, ...) {
 }
 
 /**
- * @brief Clear all effect flags and LED strip
- * This ensures clean state transitions when switching between effects
+ * @brief Name of a reset reason
  */
-void clearAllEffects() {
-  blinkEnabled = false;
-  twinkleEnabled = false;
-  twinklePlusEnabled = false;
-  goldEnabled = false;
-  vegasEnabled = false;
-  valentinesEnabled = false;
-  stPatricksEnabled = false;
-  halloweenEnabled = false;
-  christmasEnabled = false;
-  birthdayEnabled = false;
-  wildChristmasEnabled = false;
-  christmasBasicEnabled = false;
-  christmasTrainEnabled = false;
-  rainbowEnabled = false;
-  mayThe4thEnabled = false;
-  canadaDayEnabled = false;
-  newYearsEnabled = false;
-  candyCaneEnabled = false;
-  sereneEnabled = false;
-  
-  // Clear the LED strip to prevent artifacts
-  FastLED.clear();
-  FastLED.show();
+const char* resetReasonName(esp_reset_reason_t reason) {
+  switch (reason) {
+    case ESP_RST_POWERON: return "power on";
+    case ESP_RST_EXT: return "reset pin";
+    case ESP_RST_SW: return "restart";
+    case ESP_RST_PANIC: return "panic";
+    case ESP_RST_INT_WDT: return "interrupt watchdog";
+    case ESP_RST_TASK_WDT: return "task watchdog";
+    case ESP_RST_WDT: return "watchdog";
+    case ESP_RST_DEEPSLEEP: return "deep sleep";
+    case ESP_RST_BROWNOUT: return "brownout";
+    case ESP_RST_SDIO: return "SDIO";
+    default: return "unknown";
+  }
 }
 
 /**
- * @brief Turn off all LEDs in the strip
+ * @brief True if a reset reason means the firmware crashed or hung
  */
-void turnOffAllLEDs() {
-  clearAllEffects();
+bool isCrashReset(esp_reset_reason_t reason) {
+  return reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT ||
+         reason == ESP_RST_WDT || reason == ESP_RST_BROWNOUT;
 }
 
 /**
- * @brief Set all LEDs to red
+ * @brief Save what the previous boot left in RTC memory and start fresh breadcrumbs
+ * Call first thing in setup().
  */
-void allRed() {
-  clearAllEffects();
-  
-  // Use fill_solid for better performance
-  fill_solid(leds, NUM_LEDS, CRGB::Red);
-  
-  yield();  // Feed the watchdog
-  FastLED.show();
-  yield();  // Feed the watchdog again after show
-  
-  Serial.println("[LED Strip] All LEDs set to RED");
+void beginBreadcrumbs() {
+  lastResetReason = esp_reset_reason();
+  lastBreadcrumbsValid = breadcrumbs.magic == BREADCRUMB_MAGIC && lastResetReason != ESP_RST_POWERON;
+  if (lastBreadcrumbsValid) {
+    lastBreadcrumbs = breadcrumbs;
+    lastBreadcrumbs.command[sizeof(lastBreadcrumbs.command) - 1] = '\0';
+  }
+  memset(&breadcrumbs, 0, sizeof(breadcrumbs));
+  breadcrumbs.magic = BREADCRUMB_MAGIC;
 }
 
 /**
- * @brief Set all LEDs to green
+ * @brief Refresh the breadcrumbs once a second
  */
-void allGreen() {
-  clearAllEffects();
-  
-  fill_solid(leds, NUM_LEDS, CRGB::Green);
-  
-  yield();
-  FastLED.show();
-  yield();
-  
-  Serial.println("[LED Strip] All LEDs set to GREEN");
+void updateBreadcrumbs() {
+  static unsigned long lastUpdate = 0;
+  unsigned long now = millis();
+  if (now - lastUpdate < 1000) {
+    return;
+  }
+  lastUpdate = now;
+  breadcrumbs.uptimeSec = now / 1000;
+  breadcrumbs.freeHeap = ESP.getFreeHeap();
+  breadcrumbs.minFreeHeap = ESP.getMinFreeHeap();
+  breadcrumbs.qualityLevel = qualityLevel;
 }
 
 /**
- * @brief Set all LEDs to white
+ * @brief Publish why the table last reset and, after a crash, what it was doing
+ * Waits for MQTT (up to CRASH_REPORT_WAIT_MS) so the report is not lost.
  */
-void allWhite() {
-  clearAllEffects();
-  
-  fill_solid(leds, NUM_LEDS, CRGB::White);
+void reportLastReset() {
+  if (!resetReportPending || (!mqttClient.connected() && millis() < CRASH_REPORT_WAIT_MS)) {
+    return;
+  }
+  resetReportPending = false;
   
-  yield();
-  FastLED.show();
-  yield();
+  logMessageF("[System] Last reset: %s", resetReasonName(lastResetReason));
+  if (!isCrashReset(lastResetReason)) {
+    return;
+  }
+  if (lastBreadcrumbsValid) {
+    unsigned long up = lastBreadcrumbs.uptimeSec;
+    logMessageF("[System] Crashed after %luh%02lum%02lus up, free heap %u (minimum %u), quality level %d, last command '%s', loop stage %s",
+                up / 3600, (up / 60) % 60, up % 60, lastBreadcrumbs.freeHeap, lastBreadcrumbs.minFreeHeap,
+                lastBreadcrumbs.qualityLevel, lastBreadcrumbs.command,
+                lastBreadcrumbs.loopStage < LOOP_STAGE_COUNT ? loopStageNames[lastBreadcrumbs.loopStage] : "?");
+  }
   
-  Serial.println("[LED Strip] All LEDs set to WHITE");
+#if CRASH_COREDUMP
+  esp_core_dump_summary_t summary;
+  if (esp_core_dump_get_summary(&summary) == ESP_OK) {
+    String backtrace = "";
+    char pc[12];
+    for (uint32_t i = 0; i < summary.exc_bt_info.depth && i < 16; i++) {
+      snprintf(pc, sizeof(pc), " 0x%08x", summary.exc_bt_info.bt[i]);
+      backtrace += pc;
+    }
+    logMessageF("[System] Core dump: task %s, PC 0x%08x, cause %u, address 0x%08x%s",
+                summary.exc_task, summary.exc_pc, summary.ex_info.exc_cause, summary.ex_info.exc_vaddr,
+                summary.exc_bt_info.corrupted ? ", backtrace corrupted" : "");
+    logMessage("[System] Backtrace:" + backtrace);
+    logMessage("[System] Decode with xtensa-esp32-elf-addr2line -e firmware.elf <PCs>, full dump at /coredump");
+  } else {
+    logMessage("[System] No core dump in flash");
+  }
+#endif
 }
 
 /**
- * @brief Set all LEDs to blue
+ * @brief Serve the raw core dump from flash for espcoredump.py
  */
-void allBlue() {
-  clearAllEffects();
+void handleCoredump() {
+#if CRASH_COREDUMP
+  size_t address = 0;
+  size_t size = 0;
+  const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                              ESP_PARTITION_SUBTYPE_DATA_COREDUMP, NULL);
+  if (partition == NULL || esp_core_dump_image_get(&address, &size) != ESP_OK) {
+    webServer.send(404, "text/plain", "No core dump\n");
+    return;
+  }
+  webServer.setContentLength(size);
+  webServer.send(200, "application/octet-stream", "");
+  uint8_t buffer[1024];
+  for (size_t offset = 0; offset < size; offset += sizeof(buffer)) {
+    size_t n = min(size - offset, sizeof(buffer));
+    if (esp_partition_read(partition, address - partition->address + offset, buffer, n) != ESP_OK) {
+      break;
+    }
+    webServer.sendContent((const char*)buffer, n);
+  }
+#else
+  webServer.send(404, "text/plain", "This build does not write core dumps to flash\n");
+#endif
+}
+
+/**
+ * @brief Add the time since the previous frame to the fault scenario histogram
+ */
+void recordFrameInterval() {
+  unsigned long now = micros();
+  if (lastFrameMicros != 0) {
+    unsigned long interval = now - lastFrameMicros;
+    frameIntervals++;
+    if (interval > maxFrameIntervalMicros) {
+      maxFrameIntervalMicros = interval;
+    }
+    if (interval > FRAME_STALL_MS * 1000UL) {
+      frameStalls++;
+    }
+    uint8_t bucket = 0;
+    while (bucket < FRAME_INTERVAL_BUCKETS - 1 && interval >= (4000UL << bucket)) {
+      bucket++;
+    }
+    frameIntervalBuckets[bucket]++;
+  }
+  lastFrameMicros = now;
+}
+
+/**
+ * @brief Draw the OTA progress bar over the first pixels of the wire buffer
+ * Drawn after the output stage so the effect's own frame is left alone. The
+ * bar is grey, which looks the same in any colour order.
+ */
+void drawOtaOverlay() {
+  int pixels = min(OTA_BAR_PIXELS, numLeds);
+  unsigned int total = otaTotal;
+  int filled = total ? (uint32_t)pixels * otaProgress / total : 0;
+  for (int i = 0; i < pixels; i++) {
+    wireLeds[i] = i < filled ? CRGB(OTA_BAR_LEVEL, OTA_BAR_LEVEL, OTA_BAR_LEVEL) : CRGB::Black;
+  }
+}
+
+/**
+ * @brief Push the LED array out to the strip and record how long it took
+ * The frame goes through the fused output stage into the wire buffer, then
+ * FastLED transmits it with the power limiter's scale. With several outputs
+ * the measured time is that of the slowest segment, since all segments are
+ * transmitted in parallel.
+ */
+void showStrip() {
+  uint32_t channelSums[3];
+  unsigned long start = micros();
+  fusedOutput(leds, wireLeds, outputRemap, outputLut, numLeds, ledColorOrder, channelSums);
+  lastPowerScale = outputPowerScale(channelSums, numLeds, POWER_BUDGET_MW);
+  if (otaActive) {
+    drawOtaOverlay();
+  }
+  lastOutputMicros = micros() - start;
   
-  fill_solid(leds, NUM_LEDS, CRGB::Blue);
+  start = micros();
+  FastLED.show(lastPowerScale);
+  lastShowMicros = micros() - start;
   
-  yield();
-  FastLED.show();
-  yield();
+  totalShowMicros += lastShowMicros;
+  showCount++;
   
-  Serial.println("[LED Strip] All LEDs set to BLUE");
+  if (awaitingFrameMicros != 0) {
+    unsigned long latency = micros() - awaitingFrameMicros;
+    awaitingFrameMicros = 0;
+    commandFrameCount++;
+    commandFrameMicros += latency;
+    if (latency > maxCommandFrameMicros) {
+      maxCommandFrameMicros = latency;
+    }
+    if (awaitingFrameUdp) {
+      awaitingFrameUdp = false;
+      udpFrameCount++;
+      udpFrameMicros += latency;
+      if (latency > maxUdpFrameMicros) {
+        maxUdpFrameMicros = latency;
+      }
+      if (!shownUdpPending) {
+        shownUdp = awaitingUdp;
+        shownUdpMicros = latency;
+        shownUdpPending = true;
+      }
+    }
+  }
+  if (lastShowMicros > maxShowMicros) {
+    maxShowMicros = lastShowMicros;
+  }
+  
+  if (faultDurationMs != 0) {
+    recordFrameInterval();
+  }
 }
 
 /**
- * @brief Enable red blinking on all LEDs
+ * @brief Turn every pixel in the frame buffer off (does not show)
  */
-void allRedBlink() {
-  clearAllEffects();
-  blinkEnabled = true;
-  blinkState = false;
-  blinkColor = CRGB::Red;
-  lastBlinkTime = millis();
-  Serial.printf("[LED Strip] Red blink enabled (speed: %lu ms)\n", blinkSpeed);
+void clearStrip() {
+  fill_solid(leds, numLeds, CRGB::Black);
 }
 
 /**
- * @brief Enable green blinking on all LEDs
+ * @brief Sparkles to draw this frame at the current quality level
+ * @param count Sparkles the effect draws at full quality
  */
-void allGreenBlink() {
-  clearAllEffects();
-  blinkEnabled = true;
-  blinkState = false;
-  blinkColor = CRGB::Green;
-  lastBlinkTime = millis();
-  Serial.printf("[LED Strip] Green blink enabled (speed: %lu ms)\n", blinkSpeed);
+int shedCount(int count) {
+  return qualityLevel >= 1 ? max(1, count / 2) : count;
 }
 
 /**
- * @brief Enable white blinking on all LEDs
+ * @brief Render budget for an upscaled effect at the current quality level
+ * @param renderPixels Pixels the effect declares at full quality (0 = full resolution)
  */
-void allWhiteBlink() {
-  clearAllEffects();
-  blinkEnabled = true;
-  blinkState = false;
-  blinkColor = CRGB::White;
-  lastBlinkTime = millis();
-  Serial.printf("[LED Strip] White blink enabled (speed: %lu ms)\n", blinkSpeed);
+int shedRenderPixels(int renderPixels) {
+  return qualityLevel >= 2 ? renderPixels / 2 : renderPixels;
 }
 
 /**
- * @brief Enable blue blinking on all LEDs
+ * @brief Frame interval for an effect at the current quality level
+ * @param interval Interval the effect declares at full quality (ms)
  */
-void allBlueBlink() {
-  clearAllEffects();
-  blinkEnabled = true;
-  blinkState = false;
-  blinkColor = CRGB::Blue;
-  lastBlinkTime = millis();
-  Serial.printf("[LED Strip] Blue blink enabled (speed: %lu ms)\n", blinkSpeed);
+unsigned long shedInterval(unsigned long interval) {
+  return qualityLevel >= 3 ? interval * 2 : interval;
 }
 
 /**
- * @brief Enable magical twinkle effect
+ * @brief Feed one loop() time into the load shedder and step quality up or down
+ * @param loopMicros Time the loop spent working this pass
  */
-void twinkle() {
-  clearAllEffects();
-  twinkleEnabled = true;
-  lastTwinkleUpdate = millis();
+void updateLoadShedding(unsigned long loopMicros) {
+  static const char* const qualityNames[] = {
+    "full", "fewer sparkles", "reduced resolution", "reduced frame rate"
+  };
   
-  // Start with all LEDs off
-  FastLED.clear();
-  FastLED.show();
+  avgLoopMicros = avgLoopMicros + ((long)loopMicros - (long)avgLoopMicros) / 8;
+  if (loopMicros > peakLoopMicros) {
+    peakLoopMicros = loopMicros;
+  }
   
-  Serial.println("[LED Strip] Twinkle effect enabled - magical mode");
+  unsigned long now = millis();
+  if (now - lastShedCheck < SHED_CHECK_INTERVAL) {
+    return;
+  }
+  lastShedCheck = now;
+  
+  if (avgLoopMicros > FRAME_BUDGET_US) {
+    quietChecks = 0;
+    if (qualityLevel < MAX_QUALITY_LEVEL) {
+      qualityLevel++;
+      shedEvents++;
+      logMessageF("[Render] Loop %lu us (peak %lu us) over %d us budget - shedding to level %d (%s)",
+                  avgLoopMicros, peakLoopMicros, FRAME_BUDGET_US, qualityLevel, qualityNames[qualityLevel]);
+    }
+  } else if (avgLoopMicros < FRAME_BUDGET_US / 2 && qualityLevel > 0) {
+    if (++quietChecks >= SHED_RECOVER_CHECKS) {
+      quietChecks = 0;
+      qualityLevel--;
+      logMessageF("[Render] Loop %lu us back under budget - restoring level %d (%s)",
+                  avgLoopMicros, qualityLevel, qualityNames[qualityLevel]);
+    }
+  } else {
+    quietChecks = 0;
+  }
+  peakLoopMicros = 0;
 }
 
 /**
- * @brief Enable aggressive twinkle+ effect - faster and more intense twinkling
+ * @brief Close the running loop() stage and start the next one
+ * The time since the last call is charged to the stage that was running.
+ * A stage over LOOP_STALL_MS is counted as a stall and kept for
+ * publishStall(), which runs once the pass is over.
+ * @param next Stage loop() is about to run
  */
-void twinklePlus() {
-  clearAllEffects();
-  twinklePlusEnabled = true;
-  lastTwinklePlusUpdate = millis();
-  
-  // Start with all LEDs off
-  FastLED.clear();
-  FastLED.show();
-  
-  Serial.println("[LED Strip] Twinkle+ effect enabled - aggressive magical mode!");
+void enterStage(LoopStage next) {
+  unsigned long now = micros();
+  unsigned long elapsed = now - stageStartMicros;
+  LoopStageStats& stats = loopStageStats[currentStage];
+  stats.passes++;
+  stats.totalMicros += elapsed;
+  if (elapsed > stats.maxMicros) {
+    stats.maxMicros = elapsed;
+  }
+  if (elapsed > LOOP_STALL_MS * 1000UL) {
+    stats.stalls++;
+    stallsSinceLog++;
+    if (elapsed > stallMicros) {
+      stallStage = currentStage;
+      stallMicros = elapsed;
+    }
+  }
+  currentStage = next;
+  stageStartMicros = now;
+  breadcrumbs.loopStage = next;
 }
 
 /**
- * @brief Enable gold effect - golden LEDs with twinkling
+ * @brief Publish the longest stall since the last one was published
+ * Limited to one message per STALL_LOG_INTERVAL_MS so a stage that stalls
+ * every pass (a WiFi reconnect) does not flood the log; the stalls in
+ * between are still counted and named in the next message.
  */
-void gold() {
-  clearAllEffects();
-  goldEnabled = true;
-  lastGoldUpdate = millis();
-  
-  // Start with all LEDs as gold
-  for (int i = 0; i < NUM_LEDS; i++) {
-    leds[i] = CRGB(255, 180, 0);  // Gold color
+void publishStall() {
+  if (stallMicros == 0 || millis() - lastStallLogMs < STALL_LOG_INTERVAL_MS) {
+    return;
   }
-  FastLED.show();
-  
-  Serial.println("[LED Strip] Gold effect enabled - shimmering gold!");
+  lastStallLogMs = millis();
+  if (stallsSinceLog > 1) {
+    logMessageF("[Loop] Stall: %s stage held the loop %lu ms (longest of %lu stalls)",
+                loopStageNames[stallStage], stallMicros / 1000, stallsSinceLog);
+  } else {
+    logMessageF("[Loop] Stall: %s stage held the loop %lu ms",
+                loopStageNames[stallStage], stallMicros / 1000);
+  }
+  stallMicros = 0;
+  stallsSinceLog = 0;
 }
 
 /**
- * @brief Enable wild Vegas effect - crazy colors and patterns
+ * @brief Report time and stalls per loop() stage since the last report, then start a new window
  */
-void vegas() {
-  clearAllEffects();
-  vegasEnabled = true;
-  lastVegasUpdate = millis();
-  vegasHue = 0;
-  
-  Serial.println("[LED Strip] VEGAS mode enabled - let's get WILD!");
+void loopStats() {
+  logMessageF("[Loop] Stages over %lu s (stall = over %d ms):",
+              (millis() - loopStatsSince) / 1000, LOOP_STALL_MS);
+  for (uint8_t i = 0; i < LOOP_STAGE_COUNT; i++) {
+    const LoopStageStats& stats = loopStageStats[i];
+    if (stats.passes == 0) {
+      continue;
+    }
+    logMessageF("[Loop]   %-12s avg %5lu us, max %7lu us, %lu stalls",
+                loopStageNames[i], stats.totalMicros / stats.passes, stats.maxMicros, stats.stalls);
+  }
+  memset(loopStageStats, 0, sizeof(loopStageStats));
+  loopStatsSince = millis();
 }
 
 /**
- * @brief Enable romantic Valentines effect - pink and red love
+ * @brief Table position of a rendered pixel
+ * Effects drawn below full resolution index their own smaller buffer, so
+ * their pixel i sits at strip pixel i * renderStride.
  */
-void valentines() {
-  clearAllEffects();
-  valentinesEnabled = true;
-  lastValentinesUpdate = millis();
-  valentinesPhase = 0;
-  
-  Serial.println("[LED Strip] Valentine's mode enabled - spread the love!");
+const PixelCoord& pixelAt(int i) {
+  int index = i * renderStride;
+  return pixelMap[index < numLeds ? index : numLeds - 1];
 }
 
 /**
- * @brief Enable St. Patrick's Day effect - Irish green and gold
+ * @brief Render one frame of an effect at its declared resolution into leds[]
+ * @param render Effect renderer
+ * @param renderPixels Most pixels the effect needs to render (0 = full resolution);
+ *        halved while the load shedder is at level 2 or above
  */
-void stPatricks() {
-  clearAllEffects();
-  stPatricksEnabled = true;
-  lastStPatricksUpdate = millis();
-  stPatricksPhase = 0;
+void renderScaled(void (*render)(CRGB*, int), int renderPixels) {
+  int divisor = renderDivisor(shedRenderPixels(renderPixels), numLeds);
+  if (divisor == 1) {
+    render(leds, numLeds);
+    return;
+  }
   
-  Serial.println("[LED Strip] St. Patrick's mode enabled - Irish luck!");
+  int lowCount = (numLeds + divisor - 1) / divisor;
+  renderStride = divisor;
+  render(lowResLeds, lowCount);
+  renderStride = 1;
+  upscaleLinear(lowResLeds, lowCount, leds, numLeds, divisor);
 }
 
 /**
- * @brief Enable Halloween effect - spooky orange, purple, and green
+ * @brief Fetch an effect thread's frame, carving it from the effect arena on first use
+ * @param frame Pointer that holds the frame; reset to NULL by clearAllEffects()
+ * @return The frame, or NULL if the effect arena is full
  */
-void halloween() {
-  clearAllEffects();
-  halloweenEnabled = true;
-  lastHalloweenUpdate = millis();
-  halloweenPhase = 0;
-  
-  Serial.println("[LED Strip] Halloween mode enabled - spooky time!");
+template<typename T>
+T* effectFrame(T*& frame) {
+  if (frame == NULL) {
+    frame = (T*)effectArena.alloc(sizeof(T));
+  }
+  return frame;
 }
 
 /**
- * @brief Enable Christmas effect - festive red, green, white, and gold
+ * @brief Render one frame of a multi-scene effect from its timeline
+ * The scene is picked from the time since the effect was enabled, not from
+ * a frame count, so scene lengths hold when frames are dropped or shed.
+ * @param timeline Scene list of the effect
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
  */
-void christmas() {
-  clearAllEffects();
-  christmasEnabled = true;
-  lastChristmasUpdate = millis();
-  christmasPhase = 0;
-  
-  Serial.println("[LED Strip] Christmas mode enabled - ho ho ho!");
+void renderTimeline(const Timeline& timeline, CRGB* strip, int count) {
+  TimelinePosition pos = timelineAt(timeline, millis() - effectState->startMs);
+  sceneParam = pos.scene->param;
+  pos.scene->render(strip, count);
+  if (pos.level < 255) {
+    nscale8(strip, count, pos.level);
+  }
 }
 
 /**
- * @brief Enable Birthday effect - colorful celebration with confetti and candles
+ * @brief Convert a colour order name such as "GRB" to FastLED's EOrder
+ * @return true if the name was recognised
  */
-void birthday() {
-  clearAllEffects();
-  birthdayEnabled = true;
-  lastBirthdayUpdate = millis();
-  birthdayPhase = 0;
-  
-  Serial.println("[LED Strip] Birthday mode enabled - happy birthday!");
+bool parseColorOrder(const String& name, EOrder& order) {
+  const EOrder orders[] = {RGB, RBG, GRB, GBR, BRG, BGR};
+  const char* names[] = {"RGB", "RBG", "GRB", "GBR", "BRG", "BGR"};
+  for (int i = 0; i < 6; i++) {
+    if (name == names[i]) {
+      order = orders[i];
+      return true;
+    }
+  }
+  return false;
 }
 
 /**
- * @brief Enable Wild Christmas effect - fast chaotic Christmas party mode
+ * @brief Name of a colour order for log messages
  */
-void wildChristmas() {
-  clearAllEffects();
-  wildChristmasEnabled = true;
-  lastWildChristmasUpdate = millis();
-  wildChristmasPhase = 0;
-  
-  Serial.println("[LED Strip] Wild Christmas mode enabled - crazy festive!");
+const char* colorOrderName(EOrder order) {
+  switch (order) {
+    case RGB: return "RGB";
+    case RBG: return "RBG";
+    case GRB: return "GRB";
+    case GBR: return "GBR";
+    case BRG: return "BRG";
+    case BGR: return "BGR";
+  }
+  return "?";
 }
 
 /**
- * @brief Enable Christmas Basic effect - alternating red, green, white with twinkling
+ * @brief Check that a GPIO is one we have compiled a driver for
  */
-void christmasBasic() {
-  clearAllEffects();
-  christmasBasicEnabled = true;
-  lastChristmasBasicUpdate = millis();
-  
-  // Set initial pattern - red, green, white repeating
-  for (int i = 0; i < NUM_LEDS; i++) {
-    int colorIndex = i % 3;
-    if (colorIndex == 0) {
-      leds[i] = CRGB::Red;
-    } else if (colorIndex == 1) {
-      leds[i] = CRGB::Green;
-    } else {
-      leds[i] = CRGB::White;
+bool isSupportedLedPin(uint8_t pin) {
+  for (uint8_t i = 0; i < sizeof(supportedLedPins); i++) {
+    if (supportedLedPins[i] == pin) {
+      return true;
     }
   }
-  FastLED.show();
-  
-  Serial.println("[LED Strip] Christmas Basic mode enabled - red, green, white with twinkling!");
+  return false;
 }
 
 /**
- * @brief Enable Christmas Train effect - rotating red, green, white pattern
+ * @brief Load strip geometry from NVS, falling back to the compiled defaults
+ * Out of range values are replaced by defaults so a bad setting can never
+ * stop the strip from starting.
  */
-void christmasTrain() {
-  clearAllEffects();
-  christmasTrainEnabled = true;
-  lastChristmasTrainUpdate = millis();
-  christmasTrainOffset = 0;
+void loadStripConfig() {
+  Preferences prefs;
+  prefs.begin("strip", true);
   
-  // Set initial pattern - red, green, white repeating
-  for (int i = 0; i < NUM_LEDS; i++) {
-    int colorIndex = i % 3;
-    if (colorIndex == 0) {
-      leds[i] = CRGB::Red;
-    } else if (colorIndex == 1) {
-      leds[i] = CRGB::Green;
-    } else {
-      leds[i] = CRGB::White;
-    }
+  numLeds = prefs.getUShort("count", DEFAULT_NUM_LEDS);
+  ledOutputs = prefs.getUChar("outputs", 1);
+  ledChipset = prefs.getUChar("chipset", DEFAULT_LED_CHIPSET);
+  ledColorOrder = (EOrder)prefs.getUShort("order", DEFAULT_COLOR_ORDER);
+  for (int i = 0; i < MAX_LED_OUTPUTS; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "pin%d", i);
+    ledOutputPins[i] = prefs.getUChar(key, ledOutputPins[i]);
   }
-  FastLED.show();
+  prefs.end();
   
-  Serial.printf("[LED Strip] Christmas Train mode enabled - motion at %lu ms speed!\n", christmasTrainSpeed);
+  if (numLeds < 1 || numLeds > MAX_LEDS) {
+    numLeds = DEFAULT_NUM_LEDS;
+  }
+  if (ledOutputs < 1 || ledOutputs > MAX_LED_OUTPUTS || ledOutputs > numLeds) {
+    ledOutputs = 1;
+  }
+  if (ledChipset > CHIPSET_SK6812) {
+    ledChipset = DEFAULT_LED_CHIPSET;
+  }
+  if (colorOrderName(ledColorOrder)[0] == '?') {
+    ledColorOrder = DEFAULT_COLOR_ORDER;
+  }
+  for (int i = 0; i < ledOutputs; i++) {
+    if (!isSupportedLedPin(ledOutputPins[i])) {
+      ledOutputs = 1;
+      ledOutputPins[0] = DEFAULT_LED_PIN;
+      break;
+    }
+  }
 }
 
 /**
- * @brief Set the Christmas Train rotation speed
- * @param speed Speed in milliseconds (50-1000ms)
+ * @brief Bytes of frame arena needed for a given LED count
  */
-void setTrainSpeed(unsigned long speed) {
-  // Validate speed range
-  if (speed < 50) {
-    speed = 50;  // Minimum speed
-    logMessage("[LED Strip] Train speed set to minimum: 50ms");
-  } else if (speed > 1000) {
-    speed = 1000;  // Maximum speed
-    logMessage("[LED Strip] Train speed set to maximum: 1000ms");
+size_t frameArenaBytes(int count) {
+  return count * sizeof(CRGB)                // leds[] render buffer
+       + count * sizeof(CRGB)                // wireLeds[] output buffer
+       + count * sizeof(uint16_t)            // outputRemap[] physical to logical index
+       + (count / 2 + 1) * sizeof(CRGB)      // lowResLeds[] (at most half resolution)
+       + NoiseField::cacheBytes(count)       // noiseField octave cache
+       + count * sizeof(PixelCoord);         // pixelMap[] table geometry
+}
+
+/**
+ * @brief Allocate all frame buffers from one arena sized for numLeds
+ * @return true if the heap could supply the arena
+ */
+bool allocateFrameBuffers() {
+  if (!frameArena.begin(frameArenaBytes(numLeds))) {
+    return false;
   }
-  
-  christmasTrainSpeed = speed;
-  
-  char msg[100];
-  snprintf(msg, sizeof(msg), "[LED Strip] Christmas Train speed set to %lu ms (lower=faster, higher=slower)", christmasTrainSpeed);
-  logMessage(msg);
-  
-  // If train effect is running, show immediate feedback
-  if (christmasTrainEnabled) {
-    logMessage("[LED Strip] Speed change will take effect immediately!");
+  leds = (CRGB*)frameArena.alloc(numLeds * sizeof(CRGB));
+  wireLeds = (CRGB*)frameArena.alloc(numLeds * sizeof(CRGB));
+  outputRemap = (uint16_t*)frameArena.alloc(numLeds * sizeof(uint16_t));
+  lowResLeds = (CRGB*)frameArena.alloc((numLeds / 2 + 1) * sizeof(CRGB));
+  uint8_t* noiseCache = (uint8_t*)frameArena.alloc(NoiseField::cacheBytes(numLeds));
+  pixelMap = (PixelCoord*)frameArena.alloc(numLeds * sizeof(PixelCoord));
+  if (noiseCache != NULL) {
+    noiseField.begin(noiseCache, numLeds);
   }
+  return leds != NULL && wireLeds != NULL && outputRemap != NULL && lowResLeds != NULL &&
+         noiseCache != NULL && pixelMap != NULL;
 }
 
 /**
- * @brief Enable Rainbow effect - smooth spectrum animations
+ * @brief Register one output for a fixed pin, picking the chipset at runtime
+ * Controllers are always RGB order since showStrip() already swizzles.
  */
-void rainbow() {
-  clearAllEffects();
-  rainbowEnabled = true;
-  lastRainbowUpdate = millis();
-  rainbowPhase = 0;
-  
-  Serial.println("[LED Strip] Rainbow mode enabled - full spectrum!");
+template<uint8_t PIN>
+void addLedOutputOnPin(int offset, int count) {
+  switch (ledChipset) {
+    case CHIPSET_WS2811:
+      FastLED.addLeds<WS2811, PIN, RGB>(wireLeds, offset, count);
+      break;
+    case CHIPSET_SK6812:
+      FastLED.addLeds<SK6812, PIN, RGB>(wireLeds, offset, count);
+      break;
+    default:
+      FastLED.addLeds<WS2812B, PIN, RGB>(wireLeds, offset, count);
+      break;
+  }
 }
 
 /**
- * @brief Enable May The 4th effect - Star Wars themed animations
+ * @brief Register one output, mapping the runtime GPIO to its compiled driver
  */
-void mayThe4th() {
-  clearAllEffects();
-  mayThe4thEnabled = true;
-  lastMayThe4thUpdate = millis();
-  mayThe4thPhase = 0;
-  
-  Serial.println("[LED Strip] May The 4th mode enabled - may the force be with you!");
+void addLedOutput(uint8_t pin, int offset, int count) {
+  switch (pin) {
+    case 13: addLedOutputOnPin<13>(offset, count); break;
+    case 14: addLedOutputOnPin<14>(offset, count); break;
+    case 25: addLedOutputOnPin<25>(offset, count); break;
+    case 26: addLedOutputOnPin<26>(offset, count); break;
+    case 27: addLedOutputOnPin<27>(offset, count); break;
+    case 32: addLedOutputOnPin<32>(offset, count); break;
+    case 33: addLedOutputOnPin<33>(offset, count); break;
+  }
 }
 
 /**
- * @brief Enable Canada Day effect - red and white patriotic animations
+ * @brief Register one FastLED controller per output, each driving a segment of the strip
+ * The last output also takes any LEDs left over from an uneven split.
  */
-void canadaDay() {
-  clearAllEffects();
-  canadaDayEnabled = true;
-  lastCanadaDayUpdate = millis();
-  canadaDayPhase = 0;
+void setupLedOutputs() {
+  const int segment = numLeds / ledOutputs;
   
-  Serial.println("[LED Strip] Canada Day mode enabled - oh Canada!");
+  for (int i = 0; i < ledOutputs; i++) {
+    int count = (i == ledOutputs - 1) ? numLeds - segment * i : segment;
+    addLedOutput(ledOutputPins[i], segment * i, count);
+  }
 }
 
 /**
- * @brief Enable New Years effect - gold, silver, and colorful celebration
+ * @brief Report strip geometry and the memory it uses
  */
-void newYears() {
-  clearAllEffects();
-  newYearsEnabled = true;
-  lastNewYearsUpdate = millis();
-  newYearsPhase = 0;
-  
-  Serial.println("[LED Strip] New Years mode enabled - happy new year!");
+void showConfig() {
+  logMessageF("[LED Strip] %d LEDs, %s, %s order, %d output(s)",
+              numLeds, chipsetNames[ledChipset], colorOrderName(ledColorOrder), ledOutputs);
+  for (int i = 0; i < ledOutputs; i++) {
+    logMessageF("[LED Strip]   Output %d: GPIO %d", i + 1, ledOutputPins[i]);
+  }
+  logMessageF("[Output] Gamma %d.%d, brightness %d, power limit %d mW (last frame scaled %d/255)",
+              outputGammaX10 / 10, outputGammaX10 % 10, masterBrightness, POWER_BUDGET_MW, lastPowerScale);
+  logMessageF("[Layout] Sides %d,%d,%d,%d from %s corner, %s",
+              tableLayout.sides[0], tableLayout.sides[1], tableLayout.sides[2], tableLayout.sides[3],
+              cornerNames[tableLayout.startCorner], tableLayout.clockwise ? "clockwise" : "counter-clockwise");
+  logMessageF("[Memory] Frame arena: %u of %u bytes used",
+              (unsigned)frameArena.used(), (unsigned)frameArena.capacity());
+  logMessageF("[Memory]   leds[]: %u, wireLeds[]: %u, outputRemap[]: %u, lowResLeds[]: %u, noise: %u, pixelMap[]: %u bytes",
+              (unsigned)(numLeds * sizeof(CRGB)), (unsigned)(numLeds * sizeof(CRGB)),
+              (unsigned)(numLeds * sizeof(uint16_t)), (unsigned)((numLeds / 2 + 1) * sizeof(CRGB)),
+              (unsigned)NoiseField::cacheBytes(numLeds), (unsigned)(numLeds * sizeof(PixelCoord)));
+  logMessageF("[Memory] Effect arena: %u of %u bytes used by the running effect (state %u, thread frames %u)",
+              (unsigned)effectArena.used(), (unsigned)effectArena.capacity(),
+              effectState != NULL ? (unsigned)sizeof(EffectState) : 0,
+              (duelFrame != NULL ? (unsigned)sizeof(DuelFrame) : 0) +
+              (burstFrame != NULL ? (unsigned)sizeof(BurstFrame) : 0));
+  logMessageF("[Memory] Free heap: %u bytes (largest block %u, minimum ever %u)",
+              ESP.getFreeHeap(), ESP.getMaxAllocHeap(), ESP.getMinFreeHeap());
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  if (running != NULL) {
+    logMessageF("[Storage] Running from %s (%u KB slot)", running->label, (unsigned)(running->size / 1024));
+  }
+  if (fsMounted) {
+    logMessageF("[Storage] LittleFS: %u of %u KB used",
+                (unsigned)(LittleFS.usedBytes() / 1024), (unsigned)(LittleFS.totalBytes() / 1024));
+  } else {
+    logMessage("[Storage] LittleFS not mounted");
+  }
+#if MQTT_USE_TLS
+  static const char* const handshakeNames[] = {"full", "resumed"};
+  for (uint8_t i = 0; i < 2; i++) {
+    const TlsHandshakeStats& stats = tlsStats[i];
+    if (stats.count > 0) {
+      logMessageF("[MQTT] TLS %s handshakes: %lu, avg %lu ms, max %lu ms, %u bytes held, %u bytes peak",
+                  handshakeNames[i], stats.count, stats.totalMs / stats.count, stats.maxMs,
+                  (unsigned)stats.heapHeld, (unsigned)stats.maxHeapPeak);
+    }
+  }
+#endif
 }
 
 /**
- * @brief Enable Candy Cane effect - red and white stripes
+ * @brief Mount the LittleFS asset partition, formatting it if it is blank or corrupt
  */
-void candyCane() {
-  clearAllEffects();
-  candyCaneEnabled = true;
-  lastCandyCaneUpdate = millis();
-  candyCanePhase = 0;
-  
-  Serial.println("[LED Strip] Candy Cane mode enabled - sweet stripes!");
+void setupFilesystem() {
+  fsMounted = LittleFS.begin(true);
+  if (fsMounted) {
+    Serial.printf("[Storage] LittleFS mounted: %u of %u KB used\n",
+                  (unsigned)(LittleFS.usedBytes() / 1024), (unsigned)(LittleFS.totalBytes() / 1024));
+  } else {
+    Serial.println("[Storage] LittleFS mount failed - is the littlefs partition in the partition table?");
+  }
 }
 
 /**
- * @brief Enable serene sparkle effect - gentle Christmas palette sparkles
+ * @brief Time writing and reading a test file on LittleFS against the asset read budget
+ * The file is written and read in erase-block sized chunks and deleted
+ * afterwards. The strip is not updated while this runs.
  */
-void serene() {
-  clearAllEffects();
-  sereneEnabled = true;
-  lastSereneUpdate = millis();
+void benchFs() {
+  if (!fsMounted) {
+    logMessage("[Storage] LittleFS not mounted");
+    return;
+  }
+  uint8_t* buffer = (uint8_t*)malloc(FS_BENCH_CHUNK);
+  if (buffer == NULL) {
+    logMessage("[Storage] Not enough memory for the benchmark buffer");
+    return;
+  }
+  for (int i = 0; i < FS_BENCH_CHUNK; i++) {
+    buffer[i] = i;
+  }
   
-  // Start with all LEDs off for clean sparkle effect
-  FastLED.clear();
-  FastLED.show();
+  unsigned long start = micros();
+  File file = LittleFS.open(FS_BENCH_FILE, FILE_WRITE);
+  size_t written = 0;
+  while (file && written < FS_BENCH_BYTES && file.write(buffer, FS_BENCH_CHUNK) == FS_BENCH_CHUNK) {
+    written += FS_BENCH_CHUNK;
+  }
+  file.close();
+  unsigned long writeMicros = micros() - start;
   
-  Serial.println("[LED Strip] Serene effect enabled - peaceful sparkles!");
+  start = micros();
+  file = LittleFS.open(FS_BENCH_FILE, FILE_READ);
+  size_t read = 0;
+  while (file && read < written) {
+    size_t n = file.read(buffer, FS_BENCH_CHUNK);
+    if (n == 0) break;
+    read += n;
+  }
+  file.close();
+  unsigned long readMicros = micros() - start;
+  
+  LittleFS.remove(FS_BENCH_FILE);
+  free(buffer);
+  
+  if (written < FS_BENCH_BYTES || read < written) {
+    logMessageF("[Storage] Benchmark incomplete: %u of %u bytes written, %u read back (partition full?)",
+                (unsigned)written, FS_BENCH_BYTES, (unsigned)read);
+    return;
+  }
+  unsigned long writeKBps = (uint64_t)written * 1000000 / 1024 / max(writeMicros, 1UL);
+  unsigned long readKBps = (uint64_t)read * 1000000 / 1024 / max(readMicros, 1UL);
+  logMessageF("[Storage] %u KB in %u byte chunks: write %lu KB/s (%lu ms), read %lu KB/s (%lu ms)",
+              (unsigned)(written / 1024), FS_BENCH_CHUNK, writeKBps, writeMicros / 1000, readKBps, readMicros / 1000);
+  logMessageF("[Storage] Read budget %d KB/s: %s", FS_READ_BUDGET_KBPS,
+              readKBps >= FS_READ_BUDGET_KBPS ? "met" : "MISSED");
 }
 
 /**
- * @brief Set blink speed
- * @param speed Blink interval in milliseconds
+ * @brief Save a new strip geometry to NVS (applied on next reboot)
+ * @param spec "<count>,<order>,<chipset>,<pin>[,<pin>...]", e.g. "600,GRB,WS2812B,33,32"
  */
-void setSpeed(unsigned long speed) {
-  if (speed < 50) speed = 50;  // Minimum 50ms
-  if (speed > 5000) speed = 5000;  // Maximum 5000ms
-  blinkSpeed = speed;
-  Serial.printf("[LED Strip] Blink speed set to %lu ms\n", blinkSpeed);
+void setStripConfig(const String& spec) {
+  String fields[3 + MAX_LED_OUTPUTS];
+  int fieldCount = 0;
+  int start = 0;
+  while (true) {
+    int comma = spec.indexOf(',', start);
+    if (fieldCount == 3 + MAX_LED_OUTPUTS) {
+      logMessageF("[LED Strip] At most %d output pins can be listed", MAX_LED_OUTPUTS);
+      return;
+    }
+    fields[fieldCount++] = comma == -1 ? spec.substring(start) : spec.substring(start, comma);
+    if (comma == -1) break;
+    start = comma + 1;
+  }
+  
+  if (fieldCount < 4) {
+    logMessage("[LED Strip] Invalid setStrip format. Use 'setStrip:<count>,<order>,<chipset>,<pin>[,<pin>...]'");
+    return;
+  }
+  
+  long count = fields[0].toInt();
+  int outputs = fieldCount - 3;
+  if (count < 1 || count > MAX_LEDS) {
+    logMessageF("[LED Strip] LED count must be between 1 and %d", MAX_LEDS);
+    return;
+  }
+  if (outputs > count) {
+    logMessageF("[LED Strip] %d output pins listed for only %ld LEDs - each output needs at least one", outputs, count);
+    return;
+  }
+  
+  EOrder order;
+  if (!parseColorOrder(fields[1], order)) {
+    logMessageF("[LED Strip] Unknown colour order: %s", fields[1].c_str());
+    return;
+  }
+  
+  int chipset = -1;
+  for (int i = 0; i < 3; i++) {
+    if (fields[2] == chipsetNames[i]) {
+      chipset = i;
+    }
+  }
+  if (chipset == -1) {
+    logMessageF("[LED Strip] Unknown chipset: %s (use WS2812B, WS2811 or SK6812)", fields[2].c_str());
+    return;
+  }
+  
+  for (int i = 0; i < outputs; i++) {
+    if (!isSupportedLedPin(fields[3 + i].toInt())) {
+      logMessageF("[LED Strip] GPIO %s cannot drive LEDs (use 13, 14, 25, 26, 27, 32 or 33)", fields[3 + i].c_str());
+      return;
+    }
+    for (int j = 0; j < i; j++) {
+      if (fields[3 + j].toInt() == fields[3 + i].toInt()) {
+        logMessageF("[LED Strip] GPIO %s is listed more than once", fields[3 + i].c_str());
+        return;
+      }
+    }
+  }
+  
+  Preferences prefs;
+  prefs.begin("strip", false);
+  prefs.putUShort("count", count);
+  prefs.putUChar("outputs", outputs);
+  prefs.putUChar("chipset", chipset);
+  prefs.putUShort("order", order);
+  for (int i = 0; i < outputs; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "pin%d", i);
+    prefs.putUChar(key, fields[3 + i].toInt());
+  }
+  prefs.end();
+  
+  logMessageF("[LED Strip] Saved %ld LEDs, %s, %s order, %d output(s) - send 'reboot' to apply",
+              count, chipsetNames[chipset], colorOrderName(order), outputs);
+  logMessageF("[Memory] New configuration needs %u bytes of frame arena", (unsigned)frameArenaBytes(count));
 }
 
 /**
- * @brief Show help information - list all available commands
+ * @brief Rebuild outputRemap[] from a list of reversed segments
+ * @param spec "<first>-<last>[,<first>-<last>...]" in physical pixel indexes, or "none"
+ * @return Number of segments applied, or -1 if the list is malformed
  */
-void showHelp() {
-  logMessage("\n=================================");
-  logMessage("  Available MQTT Commands");
-  logMessage("=================================");
-  logMessage("Status:");
-  logMessage("  showStatus - Display WiFi/MQTT status on LEDs 0-1");
-  logMessage("");
-  logMessage("Solid Colors:");
-  logMessage("  allRed     - Set all LEDs to red");
-  logMessage("  allGreen   - Set all LEDs to green");
-  logMessage("  allWhite   - Set all LEDs to white");
-  logMessage("  allBlue    - Set all LEDs to blue");
-  logMessage("");
-  logMessage("Blinking Colors:");
-  logMessage("  allRedBlink   - Blink all LEDs red");
-  logMessage("  allGreenBlink - Blink all LEDs green");
-  logMessage("  allWhiteBlink - Blink all LEDs white");
-  logMessage("  allBlueBlink  - Blink all LEDs blue");
-  logMessage("");
-  logMessage("Special Effects:");
-  logMessage("  twinkle    - Magical twinkling effect");
-  logMessage("  twinkle+   - Aggressive fast twinkling effect");
-  logMessage("  gold       - Shimmering gold twinkling effect");
-  logMessage("  vegas      - Wild and crazy Las Vegas mode!");
-  logMessage("  valentines - Romantic pink and red love theme");
-  logMessage("  stPatricks - Irish green and gold shamrock luck");
-  logMessage("  halloween  - Spooky orange, purple, and green");
-  logMessage("  christmas  - Festive red, green, white, and gold");
-  logMessage("  christmasBasic - Classic red, green, white with twinkling");
-  logMessage("  christmasTrain - Rotating red, green, white motion");
-  logMessage("  birthday   - Colorful celebration with confetti and candles");
-  logMessage("  wildChristmas - Fast chaotic Christmas party mode");
-  logMessage("  rainbow    - Smooth spectrum animations");
-  logMessage("  mayThe4th  - Star Wars themed animations (May the 4th)");
-  logMessage("  canadaDay  - Red and white patriotic Canadian celebration");
-  logMessage("  newYears   - Gold, silver, and colorful New Year's celebration");
-  logMessage("  candyCane  - Red and white candy cane stripes");
-  logMessage("  serene     - Peaceful Christmas sparkles with gentle fading");
-  logMessage("");
-  logMessage("Configuration:");
-  logMessage("  setSpeed:<ms>      - Set blink speed (50-5000ms)");
-  logMessage("                       Example: setSpeed:500");
-  logMessage("  setTrainSpeed:<ms> - Set train rotation speed (50-1000ms)");
-  logMessage("                       Example: setTrainSpeed:150");
-  logMessage("");
-  logMessage("Information:");
-  logMessage("  help - Show this help message");
-  logMessage("=================================\n");
+int buildOutputRemap(const String& spec) {
+  for (int i = 0; i < numLeds; i++) {
+    outputRemap[i] = i;
+  }
+  if (spec == "none" || spec.length() == 0) {
+    return 0;
+  }
+  
+  int ranges = 0;
+  int start = 0;
+  while (start < (int)spec.length()) {
+    int comma = spec.indexOf(',', start);
+    String range = comma == -1 ? spec.substring(start) : spec.substring(start, comma);
+    int dash = range.indexOf('-');
+    int first = range.substring(0, dash).toInt();
+    int last = range.substring(dash + 1).toInt();
+    if (dash <= 0 || first < 0 || last >= numLeds || first >= last || ranges == MAX_REMAP_RANGES) {
+      for (int i = 0; i < numLeds; i++) {
+        outputRemap[i] = i;
+      }
+      return -1;
+    }
+    for (int i = first; i <= last; i++) {
+      outputRemap[i] = first + last - i;
+    }
+    ranges++;
+    if (comma == -1) break;
+    start = comma + 1;
+  }
+  return ranges;
 }
 
 /**
- * @brief Clear all LED effects - helper function for clean state transitions
- */
-/**
- * @brief Show connection status on first two LEDs
- * LED 0: Green = WiFi connected, Red = WiFi disconnected
- * LED 1: Green = MQTT connected, Red = MQTT disconnected
+ * @brief Load gamma and remap settings from NVS and build the output tables
  */
-void showStatus() {
-  // Disable all effects first
-  clearAllEffects();
+void loadOutputConfig() {
+  Preferences prefs;
+  prefs.begin("output", true);
+  outputGammaX10 = prefs.getUChar("gamma", 10);
+  String remap = prefs.getString("remap", "none");
+  prefs.end();
   
-  // Check WiFi status and set LED 0
-  if (WiFi.status() == WL_CONNECTED) {
-    leds[0] = CRGB::Green;
-    Serial.println("[LED Strip] WiFi connected - LED 0 set to GREEN");
-  } else {
-    leds[0] = CRGB::Red;
-    Serial.println("[LED Strip] WiFi disconnected - LED 0 set to RED");
+  if (outputGammaX10 < 10 || outputGammaX10 > 30) {
+    outputGammaX10 = 10;
   }
-  
-  // Check MQTT status and set LED 1
-  if (mqttConnected) {
-    leds[1] = CRGB::Green;
-    Serial.println("[LED Strip] MQTT connected - LED 1 set to GREEN");
-  } else {
-    leds[1] = CRGB::Red;
-    Serial.println("[LED Strip] MQTT disconnected - LED 1 set to RED");
+  buildOutputLut(outputLut, outputGammaX10, masterBrightness);
+  if (buildOutputRemap(remap) < 0) {
+    Serial.printf("[Output] Stored remap '%s' does not fit this strip, using straight order\n", remap.c_str());
   }
-  
-  // Update physical LEDs
-  FastLED.show();
 }
 
 /**
- * @brief Timer interrupt handler for LED blinking
+ * @brief Set and save the output gamma
+ * @param gammaX10 Gamma times ten (10-30)
  */
-void IRAM_ATTR onLedTimer() {
-  if (mqttConnected) {
-    // Solid on when MQTT connected
-    digitalWrite(LED_BUILTIN, HIGH);
-  } else {
-    // Slow blink when WiFi connected but MQTT not connected
-    ledState = !ledState;
-    digitalWrite(LED_BUILTIN, ledState ? HIGH : LOW);
-  }
+void setGamma(unsigned long gammaX10) {
+  if (gammaX10 < 10) gammaX10 = 10;
+  if (gammaX10 > 30) gammaX10 = 30;
+  outputGammaX10 = gammaX10;
+  buildOutputLut(outputLut, outputGammaX10, masterBrightness);
+  
+  Preferences prefs;
+  prefs.begin("output", false);
+  prefs.putUChar("gamma", outputGammaX10);
+  prefs.end();
+  
+  logMessageF("[Output] Gamma set to %d.%d", outputGammaX10 / 10, outputGammaX10 % 10);
 }
 
 /**
- * @brief MQTT callback for incoming messages
+ * @brief Set and save the reversed strip segments
+ * @param spec "<first>-<last>[,<first>-<last>...]" or "none"
  */
-void mqttCallback(char* topic, byte* payload, unsigned int length) {
-  String message = "";
-  for (unsigned int i = 0; i < length; i++) {
-    message += (char)payload[i];
+void setRemap(const String& spec) {
+  int ranges = buildOutputRemap(spec);
+  if (ranges < 0) {
+    logMessageF("[Output] Invalid remap '%s'. Use 'setRemap:<first>-<last>[,...]' (max %d) or 'setRemap:none'",
+                spec.c_str(), MAX_REMAP_RANGES);
+    return;
   }
   
-  // Trim whitespace and newlines
-  message.trim();
+  Preferences prefs;
+  prefs.begin("output", false);
+  prefs.putString("remap", ranges == 0 ? String("none") : spec);
+  prefs.end();
   
-  // Convert topic to String BEFORE using in logMessageF
-  String topicStr = String(topic);
+  logMessageF("[Output] %d reversed segment(s) saved", ranges);
+}
+
+/**
+ * @brief Compare the fused output stage with separate passes for the same work
+ * Only the CPU side is timed; nothing is transmitted. The separate-pass
+ * version mirrors what FastLED does internally (power estimate, then scale
+ * and reorder while sending) plus the extra remap and gamma passes we would
+ * otherwise need.
+ */
+void benchOutput() {
+  const int iterations = 50;
+  uint32_t channelSums[3];
+  volatile uint8_t sink = 0;
   
-  // Use Serial only in callback to avoid re-entrancy issues with MQTT
-  Serial.printf("[MQTT] Message received on topic: %s\n", topic);
-  Serial.printf("[MQTT] Payload: %s\n", message.c_str());
-  Serial.printf("[MQTT] Message length: %d\n", message.length());
+  // Fused: one pass does everything
+  unsigned long start = micros();
+  for (int n = 0; n < iterations; n++) {
+    fusedOutput(leds, wireLeds, outputRemap, outputLut, numLeds, ledColorOrder, channelSums);
+    sink += outputPowerScale(channelSums, numLeds, POWER_BUDGET_MW);
+  }
+  unsigned long fusedMicros = (micros() - start) / iterations;
   
-  // Process commands here
-  if (topicStr == String(TOPIC_CMD)) {
-    Serial.printf("[MQTT] Queuing command: %s\n", message.c_str());
-    
-    if (message == "showStatus") {
-      pendingCommand = "showStatus";
-    }
-    else if (message == "help") {
-      pendingCommand = "help";
-    }
-    else if (message == "allRed") {
-      pendingCommand = "allRed";
-    }
-    else if (message == "allRedBlink") {
-      pendingCommand = "allRedBlink";
+  // Separate passes: remap, gamma/brightness, colour order, power estimate.
+  // Brightness is already folded into outputLut, as in the fused stage, so
+  // both versions produce the same frame.
+  const uint8_t byte0 = (ledColorOrder >> 6) & 0x3;
+  const uint8_t byte1 = (ledColorOrder >> 3) & 0x3;
+  const uint8_t byte2 = ledColorOrder & 0x3;
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    for (int i = 0; i < numLeds; i++) {
+      wireLeds[i] = leds[outputRemap[i]];
     }
-    else if (message == "allGreen") {
-      pendingCommand = "allGreen";
+    for (int i = 0; i < numLeds; i++) {
+      wireLeds[i].r = outputLut[wireLeds[i].r];
+      wireLeds[i].g = outputLut[wireLeds[i].g];
+      wireLeds[i].b = outputLut[wireLeds[i].b];
     }
-    else if (message == "allGreenBlink") {
-      pendingCommand = "allGreenBlink";
+    for (int i = 0; i < numLeds; i++) {
+      CRGB c = wireLeds[i];
+      wireLeds[i].raw[0] = c.raw[byte0];
+      wireLeds[i].raw[1] = c.raw[byte1];
+      wireLeds[i].raw[2] = c.raw[byte2];
     }
-    else if (message == "allWhite") {
-      pendingCommand = "allWhite";
-    }
-    else if (message == "allWhiteBlink") {
-      pendingCommand = "allWhiteBlink";
-    }
-    else if (message == "allBlue") {
-      pendingCommand = "allBlue";
-    }
-    else if (message == "allBlueBlink") {
-      pendingCommand = "allBlueBlink";
+    sink += calculate_max_brightness_for_power_mW(wireLeds, numLeds, 255, POWER_BUDGET_MW);
+  }
+  unsigned long separateMicros = (micros() - start) / iterations;
+  (void)sink;
+  
+  // Leave the wire buffer holding a valid frame again
+  fusedOutput(leds, wireLeds, outputRemap, outputLut, numLeds, ledColorOrder, channelSums);
+  
+  logMessageF("[Output] %d LEDs: fused stage %lu us/frame, separate passes %lu us/frame",
+              numLeds, fusedMicros, separateMicros);
+  logMessageF("[Output] Last frame: output stage %lu us, transmit %lu us",
+              lastOutputMicros, lastShowMicros);
+}
+
+/**
+ * @brief Time the noise engine against FastLED's inoise8 over the whole strip
+ * The direct figures sample every octave for every pixel; the cached figure
+ * is what an effect pays per frame with NoiseField.
+ */
+void benchNoise() {
+  const int iterations = 20;
+  const uint16_t scale = 40;
+  volatile uint8_t sink = 0;
+  
+  // FastLED 2D Perlin noise, three octaves per pixel
+  unsigned long start = micros();
+  for (int n = 0; n < iterations; n++) {
+    for (int i = 0; i < numLeds; i++) {
+      for (int k = 0; k < NOISE_OCTAVES; k++) {
+        sink += inoise8((i * scale) << k, (n * 64) << k);
+      }
     }
-    else if (message == "twinkle") {
-      pendingCommand = "twinkle";
+  }
+  unsigned long perlinMicros = (micros() - start) / iterations;
+  
+  // Integer value noise, three octaves per pixel
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    for (int i = 0; i < numLeds; i++) {
+      for (int k = 0; k < NOISE_OCTAVES; k++) {
+        sink += valueNoise2D(((uint32_t)i * scale) << k, ((uint32_t)n * 64) << k);
+      }
     }
-    else if (message == "twinkle+") {
-      pendingCommand = "twinkle+";
+  }
+  unsigned long valueMicros = (micros() - start) / iterations;
+  
+  // Integer value noise through the octave cache
+  int samples = 0;
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    samples += noiseField.update(n * 64, scale);
+  }
+  unsigned long cachedMicros = (micros() - start) / iterations;
+  
+  // 1D, single octave
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    for (int i = 0; i < numLeds; i++) {
+      sink += inoise8(i * scale + n * 64);
     }
-    else if (message == "gold") {
-      pendingCommand = "gold";
-    }
-    else if (message == "vegas") {
-      pendingCommand = "vegas";
-    }
-    else if (message == "valentines") {
-      pendingCommand = "valentines";
-    }
-    else if (message == "stPatricks") {
-      pendingCommand = "stPatricks";
-    }
-    else if (message == "halloween") {
-      pendingCommand = "halloween";
-    }
-    else if (message == "christmas") {
-      pendingCommand = "christmas";
-    }
-    else if (message == "birthday") {
-      pendingCommand = "birthday";
-    }
-    else if (message == "wildChristmas") {
-      pendingCommand = "wildChristmas";
-    }
-    else if (message == "christmasBasic") {
-      pendingCommand = "christmasBasic";
-    }
-    else if (message == "christmasTrain") {
-      pendingCommand = "christmasTrain";
-    }
-    else if (message == "rainbow") {
-      pendingCommand = "rainbow";
-    }
-    else if (message == "mayThe4th") {
-      pendingCommand = "mayThe4th";
-    }
-    else if (message == "canadaDay") {
-      pendingCommand = "canadaDay";
-    }
-    else if (message == "newYears") {
-      pendingCommand = "newYears";
-    }
-    else if (message == "candyCane") {
-      pendingCommand = "candyCane";
-    }
-    else if (message == "serene") {
-      pendingCommand = "serene";
-    }
-    else if (message.startsWith("setSpeed:")) {
-      // Parse speed value from "setSpeed:500" format
-      int colonIndex = message.indexOf(':');
-      if (colonIndex != -1) {
-        unsigned long speed = message.substring(colonIndex + 1).toInt();
-        Serial.printf("[MQTT] Queuing setSpeed command: %lu ms\n", speed);
-        pendingCommand = "setSpeed";
-        pendingCommandParam = speed;
-      } else {
-        Serial.println("[MQTT] Invalid setSpeed format. Use 'setSpeed:500'");
-      }
-    }
-    else if (message.startsWith("setTrainSpeed:")) {
-      // Parse train speed value from "setTrainSpeed:150" format
-      int colonIndex = message.indexOf(':');
-      if (colonIndex != -1) {
-        unsigned long speed = message.substring(colonIndex + 1).toInt();
-        Serial.printf("[MQTT] Queuing setTrainSpeed command: %lu ms\n", speed);
-        pendingCommand = "setTrainSpeed";
-        pendingCommandParam = speed;
-      } else {
-        Serial.println("[MQTT] Invalid setTrainSpeed format. Use 'setTrainSpeed:150'");
-      }
-    }
-    else {
-      Serial.printf("[MQTT] Command not recognized: %s\n", message.c_str());
-      unknownCommand = message;  // Store for logging in loop
+  }
+  unsigned long perlin1DMicros = (micros() - start) / iterations;
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    for (int i = 0; i < numLeds; i++) {
+      sink += valueNoise1D((uint32_t)i * scale + n * 64);
     }
   }
+  unsigned long value1DMicros = (micros() - start) / iterations;
+  (void)sink;
+  
+  logMessageF("[Noise] %d LEDs, %d octaves: inoise8 %lu us, value noise %lu us, cached %lu us (%d samples/frame)",
+              numLeds, NOISE_OCTAVES, perlinMicros, valueMicros, cachedMicros, samples / iterations);
+  logMessageF("[Noise] %d LEDs, 1D single octave: inoise8 %lu us, value noise %lu us",
+              numLeds, perlin1DMicros, value1DMicros);
 }
 
 /**
- * @brief Connect to MQTT broker
+ * @brief Split the strip evenly over four sides, starting bottom-left and going clockwise
  */
-bool connectToMQTT() {
-  Serial.println("\n[MQTT] Attempting connection to broker...");
-  Serial.printf("[MQTT] Broker: %s:%d\n", MQTT_BROKER, MQTT_PORT);
+void setDefaultTableLayout() {
+  int quarter = numLeds / 4;
+  tableLayout.sides[0] = quarter;
+  tableLayout.sides[1] = quarter;
+  tableLayout.sides[2] = quarter;
+  tableLayout.sides[3] = numLeds - quarter * 3;
+  tableLayout.startCorner = CORNER_BOTTOM_LEFT;
+  tableLayout.clockwise = true;
+}
+
+/**
+ * @brief Load the table layout from NVS and compile it into pixelMap[]
+ * A stored layout that no longer matches the LED count is ignored.
+ */
+void loadTableLayout() {
+  Preferences prefs;
+  prefs.begin("layout", true);
+  bool stored = prefs.getBytes("layout", &tableLayout, sizeof(tableLayout)) == sizeof(tableLayout);
+  prefs.end();
   
-  // Generate unique client ID
-  mqttClientId = "ESP32-IndiaTable-";
-  mqttClientId += String(WiFi.macAddress());
+  if (!stored || layoutLedCount(tableLayout) != numLeds || tableLayout.startCorner > CORNER_BOTTOM_LEFT) {
+    setDefaultTableLayout();
+  }
+  buildPixelMap(tableLayout, pixelMap, numLeds);
+}
+
+/**
+ * @brief Set, compile and save the table layout
+ * @param spec "<side>,<side>,<side>,<side>,<corner>,<cw|ccw>" with sides in strip order,
+ *             e.g. "100,50,100,50,bl,cw"
+ */
+void setTableLayout(const String& spec) {
+  String fields[6];
+  int fieldCount = 0;
+  int start = 0;
+  while (fieldCount < 6) {
+    int comma = spec.indexOf(',', start);
+    fields[fieldCount++] = comma == -1 ? spec.substring(start) : spec.substring(start, comma);
+    if (comma == -1) break;
+    start = comma + 1;
+  }
   
-  Serial.printf("[MQTT] Client ID: %s\n", mqttClientId.c_str());
+  if (fieldCount != 6) {
+    logMessage("[Layout] Invalid setLayout format. Use 'setLayout:<side>,<side>,<side>,<side>,<corner>,<cw|ccw>'");
+    return;
+  }
   
-  if (mqttClient.connect(mqttClientId.c_str())) {
-    mqttConnected = true;  // Set this first so logMessage works
-    
-    logMessage("[MQTT] ✓ Connection successful!");
-    
-    // Subscribe to command topic
-    logMessageF("[MQTT] Subscribing to topic: %s", TOPIC_CMD);
-    if (mqttClient.subscribe(TOPIC_CMD)) {
-      logMessage("[MQTT] ✓ Subscription successful!");
-    } else {
-      logMessage("[MQTT] ✗ Subscription failed!");
-    }
-    
-    // Publish connection message
-    String connectMsg = mqttClientId + ": [MQTT] India Table Device Connected - MAC: " + WiFi.macAddress();
-    logMessageF("[MQTT] Publishing to topic: %s", TOPIC_MSG);
-    if (mqttClient.publish(TOPIC_MSG, connectMsg.c_str())) {
-      logMessage("[MQTT] ✓ Connection message published!");
-    } else {
-      logMessage("[MQTT] ✗ Failed to publish connection message!");
+  TableLayout layout;
+  for (int i = 0; i < 4; i++) {
+    layout.sides[i] = fields[i].toInt();
+  }
+  if (layoutLedCount(layout) != numLeds) {
+    logMessageF("[Layout] Sides add up to %d LEDs but the strip has %d", layoutLedCount(layout), numLeds);
+    return;
+  }
+  
+  int corner = -1;
+  for (int i = 0; i < 4; i++) {
+    if (fields[4] == cornerNames[i]) {
+      corner = i;
     }
-    
-    logMessage("[MQTT] LED set to SOLID (MQTT connected)");
-    logMessage("[MQTT] Console messages now mirrored to MQTT topic: IndiaTable-log");
-    return true;
-  } else {
-    Serial.printf("[MQTT] ✗ Connection failed! State: %d\n", mqttClient.state());
-    mqttConnected = false;
-    Serial.println("[MQTT] LED set to SLOW BLINK (MQTT disconnected)");
+  }
+  if (corner == -1 || (fields[5] != "cw" && fields[5] != "ccw")) {
+    logMessage("[Layout] Corner must be tl, tr, br or bl and direction cw or ccw");
+    return;
+  }
+  layout.startCorner = corner;
+  layout.clockwise = fields[5] == "cw";
+  
+  tableLayout = layout;
+  buildPixelMap(tableLayout, pixelMap, numLeds);
+  
+  Preferences prefs;
+  prefs.begin("layout", false);
+  prefs.putBytes("layout", &tableLayout, sizeof(tableLayout));
+  prefs.end();
+  
+  logMessageF("[Layout] Saved sides %d,%d,%d,%d from %s corner, %s",
+              layout.sides[0], layout.sides[1], layout.sides[2], layout.sides[3],
+              cornerNames[corner], layout.clockwise ? "clockwise" : "counter-clockwise");
+}
+
+/**
+ * @brief Clear all effect flags and LED strip
+ * This ensures clean state transitions when switching between effects
+ */
+void clearAllEffects() {
+  effectChanges++;
+  blinkEnabled = false;
+  twinkleEnabled = false;
+  twinklePlusEnabled = false;
+  goldEnabled = false;
+  vegasEnabled = false;
+  valentinesEnabled = false;
+  stPatricksEnabled = false;
+  halloweenEnabled = false;
+  christmasEnabled = false;
+  birthdayEnabled = false;
+  wildChristmasEnabled = false;
+  christmasBasicEnabled = false;
+  christmasTrainEnabled = false;
+  rainbowEnabled = false;
+  mayThe4thEnabled = false;
+  canadaDayEnabled = false;
+  newYearsEnabled = false;
+  candyCaneEnabled = false;
+  sereneEnabled = false;
+  sweepEnabled = false;
+  sidesEnabled = false;
+  
+  // Release the effect's state and thread frames in one go
+  effectArena.reset();
+  effectState = NULL;
+  duelFrame = NULL;
+  burstFrame = NULL;
+  
+  // Clear the LED strip to prevent artifacts
+  clearStrip();
+  fill_solid(lowResLeds, numLeds / 2 + 1, CRGB::Black);
+  showStrip();
+}
+
+/**
+ * @brief Carve the state of the effect being enabled from the effect arena
+ * Call straight after clearAllEffects(). The state starts zeroed, with the
+ * clocks set to now and the random generator seeded from effectSeed.
+ * @return false if the effect arena is full
+ */
+bool startEffect() {
+  effectState = (EffectState*)effectArena.alloc(sizeof(EffectState));
+  if (effectState == NULL) {
+    logMessage("[Memory] Effect arena full - effect not started");
     return false;
   }
+  effectState->startMs = millis();
+  effectState->lastUpdate = effectState->startMs;
+  effectState->rng.seed(effectSeed ? effectSeed : esp_random());
+  return true;
 }
 
 /**
- * @brief Serve HTML web interface
+ * @brief Fix the seed effects start their random generator with, for exact replays
+ * @param seed Seed to use from the next effect on (0 = fresh random seed each time)
  */
-void handleRoot() {
-  String html = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>India Table LED Controller</title>
-    <style>
-        * {
-            margin: 0;
-            padding: 0;
-            box-sizing: border-box;
-        }
-        body {
-            font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;
-            background: linear-gradient(135deg, #667eea 0%, #764ba2 100%);
-            min-height: 100vh;
-            padding: 20px;
-        }
-        .container {
-            max-width: 800px;
-            margin: 0 auto;
-            background: white;
-            border-radius: 20px;
-            box-shadow: 0 20px 60px rgba(0,0,0,0.3);
-            padding: 30px;
-        }
-        h1 {
-            text-align: center;
-            color: #333;
-            margin-bottom: 10px;
-            font-size: 2em;
-        }
-        .subtitle {
-            text-align: center;
-            color: #666;
-            margin-bottom: 30px;
-            font-size: 0.9em;
-        }
-        .section {
-            margin-bottom: 25px;
-            padding: 20px;
-            background: #f8f9fa;
-            border-radius: 10px;
-        }
-        .section h2 {
-            color: #444;
-            margin-bottom: 15px;
-            font-size: 1.2em;
-            border-bottom: 2px solid #667eea;
-            padding-bottom: 5px;
-        }
-        .button-grid {
-            display: grid;
-            grid-template-columns: repeat(auto-fit, minmax(140px, 1fr));
-            gap: 10px;
-        }
-        button {
-            padding: 12px 20px;
-            border: none;
-            border-radius: 8px;
-            font-size: 14px;
-            font-weight: 600;
-            cursor: pointer;
-            transition: all 0.3s ease;
-            box-shadow: 0 2px 5px rgba(0,0,0,0.1);
-        }
-        button:hover {
-            transform: translateY(-2px);
-            box-shadow: 0 4px 10px rgba(0,0,0,0.2);
-        }
-        button:active {
-            transform: translateY(0);
-        }
-        .btn-status { background: #6c757d; color: white; }
-        .btn-red { background: #dc3545; color: white; }
-        .btn-green { background: #28a745; color: white; }
-        .btn-white { background: #f8f9fa; color: #333; border: 1px solid #ddd; }
-        .btn-blue { background: #007bff; color: white; }
-        .btn-effect { background: linear-gradient(135deg, #667eea 0%, #764ba2 100%); color: white; }
-        .btn-holiday { background: linear-gradient(135deg, #f093fb 0%, #f5576c 100%); color: white; }
-        .speed-control {
-            margin-top: 15px;
-        }
-        .speed-control label {
-            display: block;
-            margin-bottom: 5px;
-            color: #444;
-            font-weight: 600;
-        }
-        .speed-input-group {
-            display: flex;
-            gap: 10px;
-        }
-        .speed-input-group input {
-            flex: 1;
-            padding: 10px;
-            border: 2px solid #ddd;
-            border-radius: 8px;
-            font-size: 14px;
-        }
-        .speed-input-group button {
-            flex-shrink: 0;
-        }
-        .status-bar {
-            text-align: center;
-            padding: 15px;
-            background: #e7f3ff;
-            border-radius: 8px;
-            margin-bottom: 20px;
-            border-left: 4px solid #007bff;
-        }
-        .status-bar.success {
-            background: #d4edda;
-            border-left-color: #28a745;
-        }
-        .status-bar.error {
-            background: #f8d7da;
-            border-left-color: #dc3545;
-        }
-        #response {
-            display: none;
-            font-weight: 600;
-        }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <h1>�🇳 India Table LED Controller</h1>
-        <div class="subtitle">ESP32 with 300 WS2812B LEDs · Firmware v)rawliteral";
+void setSeed(unsigned long seed) {
+  effectSeed = seed;
+  if (effectSeed == 0) {
+    logMessage("[LED Strip] Effects will use a fresh random seed");
+  } else {
+    logMessageF("[LED Strip] Effects will replay from seed %lu (applies when the next effect starts)", seed);
+  }
+}
+
+/**
+ * @brief Turn off all LEDs in the strip
+ */
+void turnOffAllLEDs() {
+  clearAllEffects();
+}
+
+/**
+ * @brief Set all LEDs to red
+ */
+void allRed() {
+  clearAllEffects();
   
-  html += FIRMWARE_VERSION;
+  // Use fill_solid for better performance
+  fill_solid(leds, numLeds, CRGB::Red);
+  
+  yield();  // Feed the watchdog
+  showStrip();
+  yield();  // Feed the watchdog again after show
+  
+  Serial.println("[LED Strip] All LEDs set to RED");
+}
+
+/**
+ * @brief Set all LEDs to green
+ */
+void allGreen() {
+  clearAllEffects();
+  
+  fill_solid(leds, numLeds, CRGB::Green);
+  
+  yield();
+  showStrip();
+  yield();
+  
+  Serial.println("[LED Strip] All LEDs set to GREEN");
+}
+
+/**
+ * @brief Set all LEDs to white
+ */
+void allWhite() {
+  clearAllEffects();
+  
+  fill_solid(leds, numLeds, CRGB::White);
+  
+  yield();
+  showStrip();
+  yield();
+  
+  Serial.println("[LED Strip] All LEDs set to WHITE");
+}
+
+/**
+ * @brief Set all LEDs to blue
+ */
+void allBlue() {
+  clearAllEffects();
+  
+  fill_solid(leds, numLeds, CRGB::Blue);
+  
+  yield();
+  showStrip();
+  yield();
+  
+  Serial.println("[LED Strip] All LEDs set to BLUE");
+}
+
+/**
+ * @brief Enable red blinking on all LEDs
+ */
+void allRedBlink() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  blinkEnabled = true;
+  blinkColor = CRGB::Red;
+  Serial.printf("[LED Strip] Red blink enabled (speed: %lu ms)\n", blinkSpeed);
+}
+
+/**
+ * @brief Enable green blinking on all LEDs
+ */
+void allGreenBlink() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  blinkEnabled = true;
+  blinkColor = CRGB::Green;
+  Serial.printf("[LED Strip] Green blink enabled (speed: %lu ms)\n", blinkSpeed);
+}
+
+/**
+ * @brief Enable white blinking on all LEDs
+ */
+void allWhiteBlink() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  blinkEnabled = true;
+  blinkColor = CRGB::White;
+  Serial.printf("[LED Strip] White blink enabled (speed: %lu ms)\n", blinkSpeed);
+}
+
+/**
+ * @brief Enable blue blinking on all LEDs
+ */
+void allBlueBlink() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  blinkEnabled = true;
+  blinkColor = CRGB::Blue;
+  Serial.printf("[LED Strip] Blue blink enabled (speed: %lu ms)\n", blinkSpeed);
+}
+
+/**
+ * @brief Enable magical twinkle effect
+ */
+void twinkle() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  twinkleEnabled = true;
+  
+  // Start with all LEDs off
+  clearStrip();
+  showStrip();
+  
+  Serial.println("[LED Strip] Twinkle effect enabled - magical mode");
+}
+
+/**
+ * @brief Enable aggressive twinkle+ effect - faster and more intense twinkling
+ */
+void twinklePlus() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  twinklePlusEnabled = true;
+  
+  // Start with all LEDs off
+  clearStrip();
+  showStrip();
+  
+  Serial.println("[LED Strip] Twinkle+ effect enabled - aggressive magical mode!");
+}
+
+/**
+ * @brief Enable gold effect - golden LEDs with twinkling
+ */
+void gold() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  goldEnabled = true;
+  
+  // Start with all LEDs as gold
+  for (int i = 0; i < numLeds; i++) {
+    leds[i] = CRGB(255, 180, 0);  // Gold color
+  }
+  showStrip();
+  
+  Serial.println("[LED Strip] Gold effect enabled - shimmering gold!");
+}
+
+/**
+ * @brief Enable wild Vegas effect - crazy colors and patterns
+ */
+void vegas() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  vegasEnabled = true;
+  
+  Serial.println("[LED Strip] VEGAS mode enabled - let's get WILD!");
+}
+
+/**
+ * @brief Enable romantic Valentines effect - pink and red love
+ */
+void valentines() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  valentinesEnabled = true;
+  
+  Serial.println("[LED Strip] Valentine's mode enabled - spread the love!");
+}
+
+/**
+ * @brief Enable St. Patrick's Day effect - Irish green and gold
+ */
+void stPatricks() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  stPatricksEnabled = true;
+  
+  Serial.println("[LED Strip] St. Patrick's mode enabled - Irish luck!");
+}
+
+/**
+ * @brief Enable Halloween effect - spooky orange, purple, and green
+ */
+void halloween() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  halloweenEnabled = true;
+  
+  Serial.println("[LED Strip] Halloween mode enabled - spooky time!");
+}
+
+/**
+ * @brief Enable Christmas effect - festive red, green, white, and gold
+ */
+void christmas() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  christmasEnabled = true;
+  
+  Serial.println("[LED Strip] Christmas mode enabled - ho ho ho!");
+}
+
+/**
+ * @brief Enable Birthday effect - colorful celebration with confetti and candles
+ */
+void birthday() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  birthdayEnabled = true;
+  
+  Serial.println("[LED Strip] Birthday mode enabled - happy birthday!");
+}
+
+/**
+ * @brief Enable Wild Christmas effect - fast chaotic Christmas party mode
+ */
+void wildChristmas() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  wildChristmasEnabled = true;
+  
+  Serial.println("[LED Strip] Wild Christmas mode enabled - crazy festive!");
+}
+
+/**
+ * @brief Enable Christmas Basic effect - alternating red, green, white with twinkling
+ */
+void christmasBasic() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  christmasBasicEnabled = true;
+  
+  // Set initial pattern - red, green, white repeating
+  for (int i = 0; i < numLeds; i++) {
+    int colorIndex = i % 3;
+    if (colorIndex == 0) {
+      leds[i] = CRGB::Red;
+    } else if (colorIndex == 1) {
+      leds[i] = CRGB::Green;
+    } else {
+      leds[i] = CRGB::White;
+    }
+  }
+  showStrip();
+  
+  Serial.println("[LED Strip] Christmas Basic mode enabled - red, green, white with twinkling!");
+}
+
+/**
+ * @brief Enable Christmas Train effect - rotating red, green, white pattern
+ */
+void christmasTrain() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  christmasTrainEnabled = true;
+  
+  // Set initial pattern - red, green, white repeating
+  for (int i = 0; i < numLeds; i++) {
+    int colorIndex = i % 3;
+    if (colorIndex == 0) {
+      leds[i] = CRGB::Red;
+    } else if (colorIndex == 1) {
+      leds[i] = CRGB::Green;
+    } else {
+      leds[i] = CRGB::White;
+    }
+  }
+  showStrip();
+  
+  Serial.printf("[LED Strip] Christmas Train mode enabled - motion at %lu ms speed!\n", christmasTrainSpeed);
+}
+
+/**
+ * @brief Set the Christmas Train rotation speed
+ * @param speed Speed in milliseconds (50-1000ms)
+ */
+void setTrainSpeed(unsigned long speed) {
+  // Validate speed range
+  if (speed < 50) {
+    speed = 50;  // Minimum speed
+    logMessage("[LED Strip] Train speed set to minimum: 50ms");
+  } else if (speed > 1000) {
+    speed = 1000;  // Maximum speed
+    logMessage("[LED Strip] Train speed set to maximum: 1000ms");
+  }
+  
+  christmasTrainSpeed = speed;
+  
+  char msg[100];
+  snprintf(msg, sizeof(msg), "[LED Strip] Christmas Train speed set to %lu ms (lower=faster, higher=slower)", christmasTrainSpeed);
+  logMessage(msg);
+  
+  // If train effect is running, show immediate feedback
+  if (christmasTrainEnabled) {
+    logMessage("[LED Strip] Speed change will take effect immediately!");
+  }
+}
+
+/**
+ * @brief Enable Rainbow effect - smooth spectrum animations
+ */
+void rainbow() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  rainbowEnabled = true;
+  
+  Serial.println("[LED Strip] Rainbow mode enabled - full spectrum!");
+}
+
+/**
+ * @brief Enable May The 4th effect - Star Wars themed animations
+ */
+void mayThe4th() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  mayThe4thEnabled = true;
+  
+  Serial.println("[LED Strip] May The 4th mode enabled - may the force be with you!");
+}
+
+/**
+ * @brief Enable Canada Day effect - red and white patriotic animations
+ */
+void canadaDay() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  canadaDayEnabled = true;
+  
+  Serial.println("[LED Strip] Canada Day mode enabled - oh Canada!");
+}
+
+/**
+ * @brief Enable New Years effect - gold, silver, and colorful celebration
+ */
+void newYears() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  newYearsEnabled = true;
+  
+  Serial.println("[LED Strip] New Years mode enabled - happy new year!");
+}
+
+/**
+ * @brief Enable Candy Cane effect - red and white stripes
+ */
+void candyCane() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  candyCaneEnabled = true;
+  
+  Serial.println("[LED Strip] Candy Cane mode enabled - sweet stripes!");
+}
+
+/**
+ * @brief Enable serene sparkle effect - gentle Christmas palette sparkles
+ */
+void serene() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  sereneEnabled = true;
+  
+  // Start with all LEDs off for clean sparkle effect
+  clearStrip();
+  showStrip();
+  
+  Serial.println("[LED Strip] Serene effect enabled - peaceful sparkles!");
+}
+
+/**
+ * @brief Enable radial sweep effect - a beam rotating around the table centre
+ */
+void sweep() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  sweepEnabled = true;
+  
+  Serial.println("[LED Strip] Sweep mode enabled - round and round!");
+}
+
+/**
+ * @brief Enable table sides effect - each edge of the table in its own colour
+ */
+void sides() {
+  clearAllEffects();
+  if (!startEffect()) {
+    return;
+  }
+  sidesEnabled = true;
+  
+  Serial.println("[LED Strip] Sides mode enabled - four colours, one table!");
+}
+
+/**
+ * @brief Set blink speed
+ * @param speed Blink interval in milliseconds
+ */
+void setSpeed(unsigned long speed) {
+  if (speed < 50) speed = 50;  // Minimum 50ms
+  if (speed > 5000) speed = 5000;  // Maximum 5000ms
+  blinkSpeed = speed;
+  Serial.printf("[LED Strip] Blink speed set to %lu ms\n", blinkSpeed);
+}
+
+/**
+ * @brief Show help information - list all available commands
+ */
+void showHelp() {
+  logMessage("\n=================================");
+  logMessage("  Available MQTT Commands");
+  logMessage("=================================");
+  logMessage("Status:");
+  logMessage("  showStatus - Display WiFi/MQTT status on LEDs 0-1");
+  logMessage("  showTiming - Report strip frame transmit time");
+  logMessage("  showConfig - Show strip geometry and memory use");
+  logMessage("  commandStats - Commands/s, drops and latency since the last report");
+  logMessage("  loopStats  - Time and stalls per loop() stage since the last report");
+  logMessage("  webStats   - Web handler requests/s, latency percentiles and heap use");
+  logMessage("  fault:<kind>,<s>[,<n>] - Inject a network fault and report frame intervals");
+  logMessage("               kinds: none, wifi, mqtt, latency (n ms), loss (n %), or fault:stop");
+  logMessage("  benchOutput - Time the output stage against separate passes");
+  logMessage("  benchRender - Time and compare reduced resolution rendering");
+  logMessage("  benchNoise  - Time the noise engine against inoise8");
+  logMessage("  benchThreads - Time effect thread resumes and the lightsaber duel");
+  logMessage("  benchRandom - Time the effect random generator against random8/16");
+  logMessage("  benchFs    - Time LittleFS writes and reads against the asset read budget");
+  logMessage("  reboot     - Restart the controller");
+  logMessage("  rollback   - Boot the firmware that ran before the last update");
+  logMessage("  setGroup:<name> - Fleet group for pullUpdate");
+  logMessage("  pullUpdate:<group|all>,<url> - Fetch a signed image from a fleet server");
+  logMessage("");
+  logMessage("Solid Colors:");
+  logMessage("  allRed     - Set all LEDs to red");
+  logMessage("  allGreen   - Set all LEDs to green");
+  logMessage("  allWhite   - Set all LEDs to white");
+  logMessage("  allBlue    - Set all LEDs to blue");
+  logMessage("");
+  logMessage("Blinking Colors:");
+  logMessage("  allRedBlink   - Blink all LEDs red");
+  logMessage("  allGreenBlink - Blink all LEDs green");
+  logMessage("  allWhiteBlink - Blink all LEDs white");
+  logMessage("  allBlueBlink  - Blink all LEDs blue");
+  logMessage("");
+  logMessage("Special Effects:");
+  logMessage("  twinkle    - Magical twinkling effect");
+  logMessage("  twinkle+   - Aggressive fast twinkling effect");
+  logMessage("  gold       - Shimmering gold twinkling effect");
+  logMessage("  vegas      - Wild and crazy Las Vegas mode!");
+  logMessage("  valentines - Romantic pink and red love theme");
+  logMessage("  stPatricks - Irish green and gold shamrock luck");
+  logMessage("  halloween  - Spooky orange, purple, and green");
+  logMessage("  christmas  - Festive red, green, white, and gold");
+  logMessage("  christmasBasic - Classic red, green, white with twinkling");
+  logMessage("  christmasTrain - Rotating red, green, white motion");
+  logMessage("  birthday   - Colorful celebration with confetti and candles");
+  logMessage("  wildChristmas - Fast chaotic Christmas party mode");
+  logMessage("  rainbow    - Smooth spectrum animations");
+  logMessage("  mayThe4th  - Star Wars themed animations (May the 4th)");
+  logMessage("  canadaDay  - Red and white patriotic Canadian celebration");
+  logMessage("  newYears   - Gold, silver, and colorful New Year's celebration");
+  logMessage("  candyCane  - Red and white candy cane stripes");
+  logMessage("  serene     - Peaceful Christmas sparkles with gentle fading");
+  logMessage("  sweep      - Beam rotating around the table centre");
+  logMessage("  sides      - Each table edge in its own colour");
+  logMessage("");
+  logMessage("Configuration:");
+  logMessage("  setSpeed:<ms>      - Set blink speed (50-5000ms)");
+  logMessage("                       Example: setSpeed:500");
+  logMessage("  setTrainSpeed:<ms> - Set train rotation speed (50-1000ms)");
+  logMessage("                       Example: setTrainSpeed:150");
+  logMessage("  setStrip:<count>,<order>,<chipset>,<pin>[,<pin>...]");
+  logMessage("                     - Save strip geometry (applied after reboot)");
+  logMessage("                       Example: setStrip:600,GRB,WS2812B,33,32");
+  logMessage("  setLayout:<side>,<side>,<side>,<side>,<corner>,<cw|ccw>");
+  logMessage("                     - Describe how the strip runs around the table");
+  logMessage("                       Example: setLayout:100,50,100,50,bl,cw");
+  logMessage("  setGamma:<x10>     - Output gamma x10 (10=linear, 22=typical)");
+  logMessage("  setSeed:<n>        - Replay effects from a fixed random seed (0=random)");
+  logMessage("  setRemap:<a>-<b>,... - Reverse strip segments (or setRemap:none)");
+  logMessage("                       Example: setRemap:75-149");
+  logMessage("");
+  logMessage("Information:");
+  logMessage("  help - Show this help message");
+  logMessage("=================================\n");
+}
+
+/**
+ * @brief Clear all LED effects - helper function for clean state transitions
+ */
+/**
+ * @brief Show connection status on first two LEDs
+ * LED 0: Green = WiFi connected, Red = WiFi disconnected
+ * LED 1: Green = MQTT connected, Red = MQTT disconnected
+ */
+void showStatus() {
+  // Disable all effects first
+  clearAllEffects();
+  
+  // Check WiFi status and set LED 0
+  if (WiFi.status() == WL_CONNECTED) {
+    leds[0] = CRGB::Green;
+    Serial.println("[LED Strip] WiFi connected - LED 0 set to GREEN");
+  } else {
+    leds[0] = CRGB::Red;
+    Serial.println("[LED Strip] WiFi disconnected - LED 0 set to RED");
+  }
+  
+  // Check MQTT status and set LED 1
+  if (mqttConnected) {
+    leds[1] = CRGB::Green;
+    Serial.println("[LED Strip] MQTT connected - LED 1 set to GREEN");
+  } else {
+    leds[1] = CRGB::Red;
+    Serial.println("[LED Strip] MQTT disconnected - LED 1 set to RED");
+  }
+  
+  // Update physical LEDs
+  showStrip();
+}
+
+/**
+ * @brief Report strip transmit time for a full parallel frame and since boot
+ */
+void showTiming() {
+  // The RMT driver holds each output until the last controller is queued and
+  // then sends them all together, so only the whole frame can be timed
+  showStrip();
+  logMessageF("[LED Strip] Parallel frame: %lu us across %d output(s)",
+              lastShowMicros, FastLED.count());
+  
+  if (showCount > 0) {
+    logMessageF("[LED Strip] Since boot: %lu frames, avg %lu us, max %lu us",
+                showCount, totalShowMicros / showCount, maxShowMicros);
+  }
+  logMessageF("[Render] Loop %lu us of %d us budget, quality level %d, %lu shedding events since boot",
+              avgLoopMicros, FRAME_BUDGET_US, qualityLevel, shedEvents);
+}
+
+/**
+ * @brief Report command throughput, drops and latency since the last report, then start a new window
+ */
+void commandStats() {
+  unsigned long elapsed = millis() - commandStatsSince;
+  logMessageF("[Commands] %lu received in %lu ms (%lu.%lu/s), %lu run, %lu dropped by the pending slot",
+              commandsReceived, elapsed,
+              elapsed ? commandsReceived * 1000 / elapsed : 0,
+              elapsed ? (commandsReceived * 10000 / elapsed) % 10 : 0,
+              commandsExecuted, commandsDropped);
+  if (commandsExecuted > 0) {
+    logMessageF("[Commands] Queue to run: avg %lu us, max %lu us",
+                commandRunMicros / commandsExecuted, maxCommandRunMicros);
+  }
+  if (commandFrameCount > 0) {
+    logMessageF("[Commands] Queue to next frame: avg %lu us, max %lu us (%lu frames)",
+                commandFrameMicros / commandFrameCount, maxCommandFrameMicros, commandFrameCount);
+  }
+  if (mqttReconnects + mqttSessionCommands + mqttDuplicates > 0) {
+    logMessageF("[Commands] MQTT session: %lu reconnects, %lu commands delivered from the session, %lu duplicates dropped",
+                mqttReconnects, mqttSessionCommands, mqttDuplicates);
+  }
+  if (udpAccepted + udpRejected + udpReplayed + udpQueueFull > 0) {
+    logMessageF("[Commands] UDP: %lu accepted, %lu rejected, %lu replayed, %lu queue full",
+                udpAccepted, udpRejected, udpReplayed, udpQueueFull);
+  }
+  if (udpFrameCount > 0) {
+    logMessageF("[Commands] UDP packet to next frame: avg %lu us, max %lu us (%lu frames)",
+                udpFrameMicros / udpFrameCount, maxUdpFrameMicros, udpFrameCount);
+  }
+  
+  commandStatsSince = millis();
+  commandsReceived = 0;
+  commandsExecuted = 0;
+  commandsDropped = 0;
+  commandRunMicros = 0;
+  maxCommandRunMicros = 0;
+  commandFrameCount = 0;
+  commandFrameMicros = 0;
+  maxCommandFrameMicros = 0;
+  mqttReconnects = 0;
+  mqttSessionCommands = 0;
+  mqttDuplicates = 0;
+  udpAccepted = 0;
+  udpRejected = 0;
+  udpReplayed = 0;
+  udpQueueFull = 0;
+  udpFrameCount = 0;
+  udpFrameMicros = 0;
+  maxUdpFrameMicros = 0;
+}
+
+/**
+ * @brief Upper bound of the frame-interval bucket holding a percentile
+ * @param percent Percentile to find (1-100)
+ * @return Bucket limit in milliseconds
+ */
+unsigned long frameIntervalPercentile(uint8_t percent) {
+  unsigned long target = (frameIntervals * percent + 99) / 100;
+  unsigned long seen = 0;
+  for (uint8_t b = 0; b < FRAME_INTERVAL_BUCKETS; b++) {
+    seen += frameIntervalBuckets[b];
+    if (seen >= target) {
+      return 4UL << b;
+    }
+  }
+  return maxFrameIntervalMicros / 1000;
+}
+
+/**
+ * @brief Put the network back the way it was and queue the scenario report
+ */
+void endFault() {
+  if (activeFault == FAULT_MQTT) {
+    mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
+  }
+  activeFault = FAULT_NONE;
+  faultDurationMs = 0;
+  faultEndMs = millis();
+  faultReportPending = true;
+}
+
+/**
+ * @brief Log the frame-interval distribution of the last scenario
+ */
+void reportFault() {
+  faultReportPending = false;
+  unsigned long seconds = (faultEndMs - faultStartMs) / 1000;
+  
+  if (frameIntervals == 0) {
+    logMessageF("[Fault] %s: no frames in %lu s - run an effect during the scenario",
+                faultNames[faultScenario], seconds);
+    return;
+  }
+  logMessageF("[Fault] %s for %lu s: %lu frames, interval p50 <%lu ms, p90 <%lu ms, p99 <%lu ms, max %lu ms, %lu over %d ms",
+              faultNames[faultScenario], seconds, frameIntervals,
+              frameIntervalPercentile(50), frameIntervalPercentile(90), frameIntervalPercentile(99),
+              maxFrameIntervalMicros / 1000, frameStalls, FRAME_STALL_MS);
+  
+  String histogram = "[Fault] Intervals:";
+  for (uint8_t b = 0; b < FRAME_INTERVAL_BUCKETS; b++) {
+    if (frameIntervalBuckets[b] > 0) {
+      histogram += " <" + String(4UL << b) + "ms:" + String(frameIntervalBuckets[b]);
+    }
+  }
+  logMessage(histogram);
+  if (faultDropped > 0) {
+    logMessageF("[Fault] %lu MQTT message(s) discarded", faultDropped);
+  }
+}
+
+/**
+ * @brief Start a network fault scenario and a fresh frame-interval histogram
+ * A scenario that is already running is ended (and reported) first.
+ * @param spec "<none|wifi|mqtt|latency|loss>,<seconds>[,<ms or percent>]" or "stop"
+ */
+void startFault(const String& spec) {
+  if (spec == "stop") {
+    if (faultDurationMs != 0) {
+      endFault();
+    }
+    return;
+  }
+  
+  int comma = spec.indexOf(',');
+  String name = comma < 0 ? spec : spec.substring(0, comma);
+  uint8_t kind = 0;
+  while (kind < FAULT_KIND_COUNT && name != faultNames[kind]) {
+    kind++;
+  }
+  long seconds = 0;
+  long value = 0;
+  if (comma >= 0) {
+    seconds = spec.substring(comma + 1).toInt();
+    int next = spec.indexOf(',', comma + 1);
+    if (next >= 0) {
+      value = spec.substring(next + 1).toInt();
+    }
+  }
+  bool needsValue = kind == FAULT_LATENCY || kind == FAULT_LOSS;
+  if (kind >= FAULT_KIND_COUNT || seconds <= 0 || seconds > FAULT_MAX_SECONDS ||
+      (needsValue && value <= 0) || (kind == FAULT_LOSS && value > 100)) {
+    logMessageF("[Fault] Invalid scenario '%s'. Use 'fault:<none|wifi|mqtt|latency|loss>,<seconds>[,<ms or %%>]' or 'fault:stop'",
+                spec.c_str());
+    return;
+  }
+  
+  if (faultDurationMs != 0) {
+    endFault();
+  }
+  if (faultReportPending) {
+    reportFault();
+  }
+  
+  // Log before the network goes away
+  logMessageF("[Fault] Running '%s' for %ld s", spec.c_str(), seconds);
+  
+  memset(frameIntervalBuckets, 0, sizeof(frameIntervalBuckets));
+  frameIntervals = 0;
+  frameStalls = 0;
+  maxFrameIntervalMicros = 0;
+  lastFrameMicros = 0;
+  faultDropped = 0;
+  activeFault = (FaultKind)kind;
+  faultScenario = activeFault;
+  faultValue = value;
+  faultStartMs = millis();
+  faultDurationMs = seconds * 1000UL;
+  
+  if (activeFault == FAULT_WIFI) {
+    WiFi.disconnect();
+  } else if (activeFault == FAULT_MQTT) {
+    mqttClient.disconnect();
+    mqttClient.setServer(FAULT_UNREACHABLE_BROKER, MQTT_PORT);
+  }
+}
+
+/**
+ * @brief End the running fault scenario when its time is up and report it
+ * The report waits for MQTT to reconnect (up to FAULT_REPORT_WAIT_MS) so it
+ * is not lost after a WiFi or broker scenario.
+ */
+void updateFault() {
+  if (faultDurationMs != 0 && millis() - faultStartMs >= faultDurationMs) {
+    endFault();
+  }
+  if (faultReportPending &&
+      (mqttClient.connected() || millis() - faultEndMs >= FAULT_REPORT_WAIT_MS)) {
+    reportFault();
+  }
+}
+
+/**
+ * @brief Timer interrupt handler for LED blinking
+ */
+void IRAM_ATTR onLedTimer() {
+  if (mqttConnected) {
+    // Solid on when MQTT connected
+    digitalWrite(LED_BUILTIN, HIGH);
+  } else {
+    // Slow blink when WiFi connected but MQTT not connected
+    ledState = !ledState;
+    digitalWrite(LED_BUILTIN, ledState ? HIGH : LOW);
+  }
+}
+
+/**
+ * @brief Parse a command and put it in the pending command slot for loop() to run
+ * Shared by MQTT, the web interface and the UDP port. There is one slot, so
+ * a command that arrives before loop() has run the previous one replaces
+ * it; those drops are counted for commandStats.
+ * @param message Command text such as "rainbow" or "setSpeed:500"
+ * @return true if the command was recognized and queued
+ */
+bool queueCommand(const String& message) {
+  Serial.printf("[MQTT] Queuing command: %s\n", message.c_str());
+  commandsReceived++;
+  String previous = pendingCommand;
+  pendingCommand = "";
+  
+  if (message == "showStatus") {
+    pendingCommand = "showStatus";
+  }
+  else if (message == "help") {
+    pendingCommand = "help";
+  }
+  else if (message == "showTiming") {
+    pendingCommand = "showTiming";
+  }
+  else if (message == "showConfig") {
+    pendingCommand = "showConfig";
+  }
+  else if (message == "benchOutput") {
+    pendingCommand = "benchOutput";
+  }
+  else if (message == "commandStats") {
+    pendingCommand = "commandStats";
+  }
+  else if (message == "loopStats") {
+    pendingCommand = "loopStats";
+  }
+  else if (message == "webStats") {
+    pendingCommand = "webStats";
+  }
+  else if (message == "benchRender") {
+    pendingCommand = "benchRender";
+  }
+  else if (message == "benchNoise") {
+    pendingCommand = "benchNoise";
+  }
+  else if (message == "benchThreads") {
+    pendingCommand = "benchThreads";
+  }
+  else if (message == "benchRandom") {
+    pendingCommand = "benchRandom";
+  }
+  else if (message == "benchFs") {
+    pendingCommand = "benchFs";
+  }
+  else if (message == "reboot") {
+    pendingCommand = "reboot";
+  }
+  else if (message == "rollback") {
+    pendingCommand = "rollback";
+  }
+  else if (message == "allRed") {
+    pendingCommand = "allRed";
+  }
+  else if (message == "allRedBlink") {
+    pendingCommand = "allRedBlink";
+  }
+  else if (message == "allGreen") {
+    pendingCommand = "allGreen";
+  }
+  else if (message == "allGreenBlink") {
+    pendingCommand = "allGreenBlink";
+  }
+  else if (message == "allWhite") {
+    pendingCommand = "allWhite";
+  }
+  else if (message == "allWhiteBlink") {
+    pendingCommand = "allWhiteBlink";
+  }
+  else if (message == "allBlue") {
+    pendingCommand = "allBlue";
+  }
+  else if (message == "allBlueBlink") {
+    pendingCommand = "allBlueBlink";
+  }
+  else if (message == "twinkle") {
+    pendingCommand = "twinkle";
+  }
+  else if (message == "twinkle+") {
+    pendingCommand = "twinkle+";
+  }
+  else if (message == "gold") {
+    pendingCommand = "gold";
+  }
+  else if (message == "vegas") {
+    pendingCommand = "vegas";
+  }
+  else if (message == "valentines") {
+    pendingCommand = "valentines";
+  }
+  else if (message == "stPatricks") {
+    pendingCommand = "stPatricks";
+  }
+  else if (message == "halloween") {
+    pendingCommand = "halloween";
+  }
+  else if (message == "christmas") {
+    pendingCommand = "christmas";
+  }
+  else if (message == "birthday") {
+    pendingCommand = "birthday";
+  }
+  else if (message == "wildChristmas") {
+    pendingCommand = "wildChristmas";
+  }
+  else if (message == "christmasBasic") {
+    pendingCommand = "christmasBasic";
+  }
+  else if (message == "christmasTrain") {
+    pendingCommand = "christmasTrain";
+  }
+  else if (message == "rainbow") {
+    pendingCommand = "rainbow";
+  }
+  else if (message == "mayThe4th") {
+    pendingCommand = "mayThe4th";
+  }
+  else if (message == "canadaDay") {
+    pendingCommand = "canadaDay";
+  }
+  else if (message == "newYears") {
+    pendingCommand = "newYears";
+  }
+  else if (message == "candyCane") {
+    pendingCommand = "candyCane";
+  }
+  else if (message == "serene") {
+    pendingCommand = "serene";
+  }
+  else if (message == "sweep") {
+    pendingCommand = "sweep";
+  }
+  else if (message == "sides") {
+    pendingCommand = "sides";
+  }
+  else if (message.startsWith("setSpeed:")) {
+    // Parse speed value from "setSpeed:500" format
+    int colonIndex = message.indexOf(':');
+    if (colonIndex != -1) {
+      unsigned long speed = message.substring(colonIndex + 1).toInt();
+      Serial.printf("[MQTT] Queuing setSpeed command: %lu ms\n", speed);
+      pendingCommand = "setSpeed";
+      pendingCommandParam = speed;
+    } else {
+      Serial.println("[MQTT] Invalid setSpeed format. Use 'setSpeed:500'");
+    }
+  }
+  else if (message.startsWith("setTrainSpeed:")) {
+    // Parse train speed value from "setTrainSpeed:150" format
+    int colonIndex = message.indexOf(':');
+    if (colonIndex != -1) {
+      unsigned long speed = message.substring(colonIndex + 1).toInt();
+      Serial.printf("[MQTT] Queuing setTrainSpeed command: %lu ms\n", speed);
+      pendingCommand = "setTrainSpeed";
+      pendingCommandParam = speed;
+    } else {
+      Serial.println("[MQTT] Invalid setTrainSpeed format. Use 'setTrainSpeed:150'");
+    }
+  }
+  else if (message.startsWith("setGamma:")) {
+    unsigned long gamma = message.substring(9).toInt();
+    Serial.printf("[MQTT] Queuing setGamma command: %lu\n", gamma);
+    pendingCommand = "setGamma";
+    pendingCommandParam = gamma;
+  }
+  else if (message.startsWith("setSeed:")) {
+    unsigned long seed = strtoul(message.c_str() + 8, NULL, 10);
+    Serial.printf("[MQTT] Queuing setSeed command: %lu\n", seed);
+    pendingCommand = "setSeed";
+    pendingCommandParam = seed;
+  }
+  else if (message.startsWith("pullUpdate:")) {
+    Serial.printf("[MQTT] Queuing pullUpdate command: %s\n", message.c_str() + 11);
+    pendingCommand = "pullUpdate";
+    pendingCommandArg = message.substring(11);
+  }
+  else if (message.startsWith("setGroup:")) {
+    Serial.printf("[MQTT] Queuing setGroup command: %s\n", message.c_str() + 9);
+    pendingCommand = "setGroup";
+    pendingCommandArg = message.substring(9);
+  }
+  else if (message.startsWith("fault:")) {
+    // Scenario is validated when the command runs in loop()
+    Serial.printf("[MQTT] Queuing fault command: %s\n", message.c_str() + 6);
+    pendingCommand = "fault";
+    pendingCommandArg = message.substring(6);
+  }
+  else if (message.startsWith("setRemap:")) {
+    Serial.printf("[MQTT] Queuing setRemap command: %s\n", message.c_str() + 9);
+    pendingCommand = "setRemap";
+    pendingCommandArg = message.substring(9);
+  }
+  else if (message.startsWith("setLayout:")) {
+    Serial.printf("[MQTT] Queuing setLayout command: %s\n", message.c_str() + 10);
+    pendingCommand = "setLayout";
+    pendingCommandArg = message.substring(10);
+  }
+  else if (message.startsWith("setStrip:")) {
+    // Geometry is validated when the command runs in loop()
+    Serial.printf("[MQTT] Queuing setStrip command: %s\n", message.c_str() + 9);
+    pendingCommand = "setStrip";
+    pendingCommandArg = message.substring(9);
+  }
+  else {
+    Serial.printf("[MQTT] Command not recognized: %s\n", message.c_str());
+    unknownCommand = message;  // Store for logging in loop
+  }
+  
+  if (pendingCommand == "") {
+    // Not recognized - whatever was waiting still runs
+    pendingCommand = previous;
+    return false;
+  }
+  if (previous != "") {
+    commandsDropped++;
+  }
+  commandQueuedMicros = micros();
+  pendingFromUdp = false;
+  return true;
+}
+
+/**
+ * @brief Strip the "@<id> " prefix from a command and check the id against recent ones
+ * @param message Command, with the prefix removed on return
+ * @return true if this id was seen recently (the command is a duplicate)
+ */
+bool isDuplicateCommand(String& message) {
+  int space = message.indexOf(' ');
+  if (!message.startsWith("@") || space < 2) {
+    return false;
+  }
+  String id = message.substring(1, min(space, MQTT_DEDUPE_ID_MAX + 1));
+  message = message.substring(space + 1);
+  message.trim();
+  
+  for (uint8_t i = 0; i < MQTT_DEDUPE_IDS; i++) {
+    if (id == mqttRecentIds[i]) {
+      return true;
+    }
+  }
+  strncpy(mqttRecentIds[mqttRecentIdNext], id.c_str(), MQTT_DEDUPE_ID_MAX);
+  mqttRecentIdNext = (mqttRecentIdNext + 1) % MQTT_DEDUPE_IDS;
+  return false;
+}
+
+/**
+ * @brief MQTT callback for incoming messages
+ */
+void mqttCallback(char* topic, byte* payload, unsigned int length) {
+  // Injected packet loss: the message never arrived
+  if (activeFault == FAULT_LOSS && esp_random() % 100 < faultValue) {
+    faultDropped++;
+    return;
+  }
+  
+  String message = "";
+  for (unsigned int i = 0; i < length; i++) {
+    message += (char)payload[i];
+  }
+  
+  // Trim whitespace and newlines
+  message.trim();
+  
+  // Convert topic to String BEFORE using in logMessageF
+  String topicStr = String(topic);
+  
+  // Use Serial only in callback to avoid re-entrancy issues with MQTT
+  Serial.printf("[MQTT] Message received on topic: %s\n", topic);
+  Serial.printf("[MQTT] Payload: %s\n", message.c_str());
+  Serial.printf("[MQTT] Message length: %d\n", message.length());
+  
+  // Process commands here
+  if (topicStr == String(TOPIC_CMD)) {
+    if (isDuplicateCommand(message)) {
+      Serial.printf("[MQTT] Duplicate dropped: %s\n", message.c_str());
+      mqttDuplicates++;
+      return;
+    }
+    if (millis() - mqttConnectedAt < MQTT_BACKLOG_WINDOW_MS) {
+      mqttBacklog++;
+      mqttSessionCommands++;
+    }
+    queueCommand(message);
+  }
+}
+
+/**
+ * @brief Connect to MQTT broker
+ */
+bool connectToMQTT() {
+  Serial.println("\n[MQTT] Attempting connection to broker...");
+  Serial.printf("[MQTT] Broker: %s:%d\n", MQTT_BROKER, MQTT_PORT);
+  
+  // Generate unique client ID
+  mqttClientId = "ESP32-IndiaTable-";
+  mqttClientId += String(WiFi.macAddress());
+  
+  Serial.printf("[MQTT] Client ID: %s\n", mqttClientId.c_str());
+  
+  // Persistent session (cleanSession off): the broker queues QoS 1 commands
+  // for this client ID while the table is offline
+  if (mqttClient.connect(mqttClientId.c_str(), NULL, NULL, NULL, 0, false, NULL, false)) {
+    mqttConnected = true;  // Set this first so logMessage works
+    mqttConnectedAt = millis();
+    mqttBacklog = 0;
+    mqttSessionReportPending = true;
+    
+    logMessage("[MQTT] ✓ Connection successful!");
+#if MQTT_USE_TLS
+    TlsHandshakeStats& stats = tlsStats[espClient.lastResumed() ? 1 : 0];
+    stats.count++;
+    stats.totalMs += espClient.lastHandshakeMs();
+    stats.maxMs = max(stats.maxMs, espClient.lastHandshakeMs());
+    stats.heapHeld = espClient.lastHeapHeld();
+    stats.maxHeapPeak = max(stats.maxHeapPeak, espClient.lastHeapPeak());
+    logMessageF("[MQTT] TLS %s handshake: %lu ms, %u bytes held, %u bytes peak",
+                espClient.lastResumed() ? "resumed" : "full", espClient.lastHandshakeMs(),
+                (unsigned)espClient.lastHeapHeld(), (unsigned)espClient.lastHeapPeak());
+#endif
+    
+    // Subscribe to command topic (kept by the session, renewed in case the broker dropped it)
+    logMessageF("[MQTT] Subscribing to topic: %s (QoS %d)", TOPIC_CMD, MQTT_CMD_QOS);
+    if (mqttClient.subscribe(TOPIC_CMD, MQTT_CMD_QOS)) {
+      logMessage("[MQTT] ✓ Subscription successful!");
+    } else {
+      logMessage("[MQTT] ✗ Subscription failed!");
+    }
+    
+    // Publish connection message
+    String connectMsg = mqttClientId + ": [MQTT] India Table Device Connected - MAC: " + WiFi.macAddress();
+    logMessageF("[MQTT] Publishing to topic: %s", TOPIC_MSG);
+    if (mqttClient.publish(TOPIC_MSG, connectMsg.c_str())) {
+      logMessage("[MQTT] ✓ Connection message published!");
+    } else {
+      logMessage("[MQTT] ✗ Failed to publish connection message!");
+    }
+    
+    logMessage("[MQTT] LED set to SOLID (MQTT connected)");
+    logMessage("[MQTT] Console messages now mirrored to MQTT topic: IndiaTable-log");
+    return true;
+  } else {
+    Serial.printf("[MQTT] ✗ Connection failed! State: %d\n", mqttClient.state());
+#if MQTT_USE_TLS
+    if (espClient.lastError() != 0) {
+      Serial.printf("[MQTT] TLS error: -0x%04x\n", -espClient.lastError());
+    }
+#endif
+    mqttConnected = false;
+    Serial.println("[MQTT] LED set to SLOW BLINK (MQTT disconnected)");
+    return false;
+  }
+}
+
+/**
+ * @brief Log how long the table was offline and how many commands the broker kept for it
+ * Runs once the backlog window after a connect has passed.
+ */
+void reportMqttSession() {
+  if (!mqttSessionReportPending || millis() - mqttConnectedAt < MQTT_BACKLOG_WINDOW_MS) {
+    return;
+  }
+  mqttSessionReportPending = false;
+  if (mqttOfflineMs > 0) {
+    logMessageF("[MQTT] Session resumed after %lu.%lu s offline, %lu command(s) delivered from the session",
+                mqttOfflineMs / 1000, (mqttOfflineMs / 100) % 10, mqttBacklog);
+    mqttOfflineMs = 0;
+  } else if (mqttBacklog > 0) {
+    logMessageF("[MQTT] %lu command(s) delivered from the session", mqttBacklog);
+  }
+}
+
+/**
+ * @brief Serve HTML web interface
+ */
+void handleRoot() {
+  String html = R"rawliteral(
+<!DOCTYPE html>
+<html>
+<head>
+    <meta charset="UTF-8">
+    <meta name="viewport" content="width=device-width, initial-scale=1.0">
+    <title>India Table LED Controller</title>
+    <style>
+        * {
+            margin: 0;
+            padding: 0;
+            box-sizing: border-box;
+        }
+        body {
+            font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;
+            background: linear-gradient(135deg, #667eea 0%, #764ba2 100%);
+            min-height: 100vh;
+            padding: 20px;
+        }
+        .container {
+            max-width: 800px;
+            margin: 0 auto;
+            background: white;
+            border-radius: 20px;
+            box-shadow: 0 20px 60px rgba(0,0,0,0.3);
+            padding: 30px;
+        }
+        h1 {
+            text-align: center;
+            color: #333;
+            margin-bottom: 10px;
+            font-size: 2em;
+        }
+        .subtitle {
+            text-align: center;
+            color: #666;
+            margin-bottom: 30px;
+            font-size: 0.9em;
+        }
+        .section {
+            margin-bottom: 25px;
+            padding: 20px;
+            background: #f8f9fa;
+            border-radius: 10px;
+        }
+        .section h2 {
+            color: #444;
+            margin-bottom: 15px;
+            font-size: 1.2em;
+            border-bottom: 2px solid #667eea;
+            padding-bottom: 5px;
+        }
+        .button-grid {
+            display: grid;
+            grid-template-columns: repeat(auto-fit, minmax(140px, 1fr));
+            gap: 10px;
+        }
+        button {
+            padding: 12px 20px;
+            border: none;
+            border-radius: 8px;
+            font-size: 14px;
+            font-weight: 600;
+            cursor: pointer;
+            transition: all 0.3s ease;
+            box-shadow: 0 2px 5px rgba(0,0,0,0.1);
+        }
+        button:hover {
+            transform: translateY(-2px);
+            box-shadow: 0 4px 10px rgba(0,0,0,0.2);
+        }
+        button:active {
+            transform: translateY(0);
+        }
+        .btn-status { background: #6c757d; color: white; }
+        .btn-red { background: #dc3545; color: white; }
+        .btn-green { background: #28a745; color: white; }
+        .btn-white { background: #f8f9fa; color: #333; border: 1px solid #ddd; }
+        .btn-blue { background: #007bff; color: white; }
+        .btn-effect { background: linear-gradient(135deg, #667eea 0%, #764ba2 100%); color: white; }
+        .btn-holiday { background: linear-gradient(135deg, #f093fb 0%, #f5576c 100%); color: white; }
+        .speed-control {
+            margin-top: 15px;
+        }
+        .speed-control label {
+            display: block;
+            margin-bottom: 5px;
+            color: #444;
+            font-weight: 600;
+        }
+        .speed-input-group {
+            display: flex;
+            gap: 10px;
+        }
+        .speed-input-group input {
+            flex: 1;
+            padding: 10px;
+            border: 2px solid #ddd;
+            border-radius: 8px;
+            font-size: 14px;
+        }
+        .speed-input-group button {
+            flex-shrink: 0;
+        }
+        .status-bar {
+            text-align: center;
+            padding: 15px;
+            background: #e7f3ff;
+            border-radius: 8px;
+            margin-bottom: 20px;
+            border-left: 4px solid #007bff;
+        }
+        .status-bar.success {
+            background: #d4edda;
+            border-left-color: #28a745;
+        }
+        .status-bar.error {
+            background: #f8d7da;
+            border-left-color: #dc3545;
+        }
+        #response {
+            display: none;
+            font-weight: 600;
+        }
+        #state {
+            font-size: 0.9em;
+            color: #555;
+        }
+        #state.offline {
+            background: #fff3cd;
+            border-left-color: #ffc107;
+        }
+    </style>
+</head>
+<body>
+    <div class="container">
+        <h1>�🇳 India Table LED Controller</h1>
+        <div class="subtitle">ESP32 with )rawliteral";
+  
+  html += String(numLeds) + " " + chipsetNames[ledChipset] + " LEDs";
+  if (ledOutputs > 1) {
+    html += " on " + String(ledOutputs) + " outputs";
+  }
+  html += " · Firmware v";
+  html += FIRMWARE_VERSION;
   
   html += R"rawliteral(</div>
         
+        <div id="state" class="status-bar offline">Connecting to live status...</div>
         <div id="response" class="status-bar"></div>
         
         <div class="section">
@@ -1073,6 +3108,7 @@ void handleRoot() {
             <div class="button-grid">
                 <button class="btn-status" onclick="sendCommand('showStatus')">Show Status</button>
                 <button class="btn-status" onclick="sendCommand('help')">Help</button>
+                <button class="btn-status" onclick="sendCommand('showTiming')">Show Timing</button>
             </div>
         </div>
         
@@ -1118,6 +3154,8 @@ void handleRoot() {
                 <button class="btn-effect" onclick="sendCommand('gold')">Gold</button>
                 <button class="btn-effect" onclick="sendCommand('vegas')">Vegas</button>
                 <button class="btn-effect" onclick="sendCommand('rainbow')">Rainbow</button>
+                <button class="btn-effect" onclick="sendCommand('sweep')">Sweep</button>
+                <button class="btn-effect" onclick="sendCommand('sides')">Sides</button>
             </div>
         </div>
         
@@ -1141,260 +3179,2780 @@ void handleRoot() {
         </div>
     </div>
     
-    <script>
-        function sendCommand(cmd) {
-            showResponse('Sending: ' + cmd + '...', 'info');
-            
-            fetch('/cmd?command=' + encodeURIComponent(cmd))
-                .then(response => response.text())
-                .then(data => {
-                    showResponse(data, 'success');
-                })
-                .catch(error => {
-                    showResponse('Error: ' + error, 'error');
-                });
-        }
-        
-        function setSpeed() {
-            const speed = document.getElementById('speedValue').value;
-            if (speed < 50 || speed > 5000) {
-                showResponse('Speed must be between 50 and 5000 ms', 'error');
-                return;
-            }
-            sendCommand('setSpeed:' + speed);
-        }
+    <script>
+        function sendCommand(cmd) {
+            showResponse('Sending: ' + cmd + '...', 'info');
+            
+            fetch('/cmd?command=' + encodeURIComponent(cmd))
+                .then(response => response.text().then(data => {
+                    showResponse(data, response.ok ? 'success' : 'error');
+                }))
+                .catch(error => {
+                    showResponse('Error: ' + error, 'error');
+                });
+        }
+        
+        function setSpeed() {
+            const speed = document.getElementById('speedValue').value;
+            if (speed < 50 || speed > 5000) {
+                showResponse('Speed must be between 50 and 5000 ms', 'error');
+                return;
+            }
+            sendCommand('setSpeed:' + speed);
+        }
+        
+        function setTrainSpeed() {
+            const speed = document.getElementById('trainSpeedValue').value;
+            if (speed < 50 || speed > 1000) {
+                showResponse('Train speed must be between 50 and 1000 ms', 'error');
+                return;
+            }
+            sendCommand('setTrainSpeed:' + speed);
+        }
+        
+        // Live state pushed by the table (Server-Sent Events); the browser
+        // reopens the stream by itself if it drops
+        const events = new EventSource('/events');
+        events.addEventListener('state', (e) => {
+            const s = JSON.parse(e.data);
+            const stateDiv = document.getElementById('state');
+            stateDiv.textContent = 'Effect: ' + s.effect +
+                ' · Blink ' + s.blinkSpeed + ' ms · Train ' + s.trainSpeed + ' ms' +
+                ' · WiFi ' + (s.wifi ? '✓' : '✗') + ' · MQTT ' + (s.mqtt ? '✓' : '✗') +
+                (s.quality > 0 ? ' · Quality level ' + s.quality : '');
+            stateDiv.className = 'status-bar';
+            for (const [id, value] of [['speedValue', s.blinkSpeed], ['trainSpeedValue', s.trainSpeed]]) {
+                if (document.activeElement.id !== id) {
+                    document.getElementById(id).value = value;
+                }
+            }
+        });
+        events.onerror = () => {
+            const stateDiv = document.getElementById('state');
+            stateDiv.textContent = 'Live status disconnected - reconnecting...';
+            stateDiv.className = 'status-bar offline';
+        };
+        
+        function showResponse(message, type) {
+            const responseDiv = document.getElementById('response');
+            responseDiv.textContent = message;
+            responseDiv.className = 'status-bar ' + type;
+            responseDiv.style.display = 'block';
+            
+            if (type === 'success') {
+                setTimeout(() => {
+                    responseDiv.style.display = 'none';
+                }, 3000);
+            }
+        }
+    </script>
+</body>
+</html>
+)rawliteral";
+  
+  webServer.send(200, "text/html", html);
+}
+
+/**
+ * @brief Handle command requests from web interface
+ */
+void handleCommand() {
+  if (webServer.hasArg("command")) {
+    String command = webServer.arg("command");
+    command.trim();
+    if (!queueCommand(command)) {
+      webServer.send(400, "text/plain", "Command not recognized: " + command);
+      return;
+    }
+    
+    String response = "Command received: " + command;
+    logMessage("[Web] " + response);
+    webServer.send(200, "text/plain", response);
+  } else {
+    webServer.send(400, "text/plain", "Missing command parameter");
+  }
+}
+
+/**
+ * @brief Run a web handler and record its time and heap use against its route
+ * @param route Route being served
+ * @param handler Handler to run
+ */
+void timedWebHandler(WebRoute route, void (*handler)()) {
+  uint32_t heapBefore = ESP.getFreeHeap();
+  unsigned long start = micros();
+  handler();
+  unsigned long elapsed = micros() - start;
+  
+  WebRouteStats& stats = webStats[route];
+  stats.requests++;
+  stats.totalMicros += elapsed;
+  if (elapsed > stats.maxMicros) {
+    stats.maxMicros = elapsed;
+  }
+  stats.heapDelta += (long)ESP.getFreeHeap() - (long)heapBefore;
+  
+  uint8_t bucket = 0;
+  while (bucket < WEB_LATENCY_BUCKETS - 1 && elapsed >= (32UL << bucket)) {
+    bucket++;
+  }
+  stats.buckets[bucket]++;
+}
+
+/**
+ * @brief Upper bound of the latency bucket holding a percentile
+ * @param stats Route statistics
+ * @param percent Percentile to find (1-100)
+ * @return Bucket limit in microseconds
+ */
+unsigned long webLatencyPercentile(const WebRouteStats& stats, uint8_t percent) {
+  unsigned long target = (stats.requests * percent + 99) / 100;
+  unsigned long seen = 0;
+  for (uint8_t b = 0; b < WEB_LATENCY_BUCKETS; b++) {
+    seen += stats.buckets[b];
+    if (seen >= target) {
+      return 32UL << b;
+    }
+  }
+  return stats.maxMicros;
+}
+
+/**
+ * @brief Web handler statistics since the last reset, one line per route
+ */
+String webStatsReport() {
+  unsigned long elapsed = millis() - webStatsSince;
+  String report = "";
+  char line[200];
+  for (uint8_t r = 0; r < WEB_ROUTE_COUNT; r++) {
+    const WebRouteStats& stats = webStats[r];
+    if (stats.requests == 0) {
+      snprintf(line, sizeof(line), "%s: no requests\n", webRouteNames[r]);
+    } else {
+      snprintf(line, sizeof(line),
+               "%s: %lu requests (%lu/s), avg %lu us, p50 <%lu us, p90 <%lu us, p99 <%lu us, max %lu us, heap %ld bytes/request\n",
+               webRouteNames[r], stats.requests, elapsed ? stats.requests * 1000 / elapsed : 0,
+               stats.totalMicros / stats.requests, webLatencyPercentile(stats, 50),
+               webLatencyPercentile(stats, 90), webLatencyPercentile(stats, 99), stats.maxMicros,
+               stats.heapDelta / (long)stats.requests);
+    }
+    report += line;
+  }
+  uint8_t open = 0;
+  for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (sseClients[i].connected()) {
+      open++;
+    }
+  }
+  snprintf(line, sizeof(line), "event streams: %d open (max %d), %lu refused, %lu events sent\n",
+           open, SSE_MAX_CLIENTS, sseRefused, sseEventsSent);
+  report += line;
+  return report;
+}
+
+/**
+ * @brief Start a new web statistics window
+ */
+void resetWebStats() {
+  memset(webStats, 0, sizeof(webStats));
+  webStatsSince = millis();
+  sseEventsSent = 0;
+  sseRefused = 0;
+}
+
+/**
+ * @brief Log the web handler statistics to MQTT
+ */
+void showWebStats() {
+  String report = webStatsReport();
+  int start = 0;
+  while (start < (int)report.length()) {
+    int end = report.indexOf('\n', start);
+    logMessage("[Web] " + report.substring(start, end));
+    start = end + 1;
+  }
+}
+
+/**
+ * @brief Serve the web handler statistics as text; /stats?reset=1 also starts a new window
+ */
+void handleStats() {
+  webServer.send(200, "text/plain", webStatsReport());
+  if (webServer.hasArg("reset")) {
+    resetWebStats();
+  }
+}
+
+/**
+ * @brief Serve the favicon
+ */
+void handleFavicon() {
+  webServer.send_P(200, "image/x-icon", (const char*)favicon_ico, favicon_ico_len);
+}
+
+/**
+ * @brief Serve the last rendered frame as raw RGB bytes, 3 per LED in strip order
+ * This is the effect's own output, before remap, gamma, brightness and the
+ * power limit. X-Frame carries the frame count so a viewer can tell a new
+ * frame from one it already has. Nothing is copied unless this is requested.
+ */
+void handleFrame() {
+  webServer.sendHeader("X-Frame", String(showCount));
+  webServer.sendHeader("X-Leds", String(numLeds));
+  webServer.send_P(200, "application/octet-stream", (const char*)leds, numLeds * sizeof(CRGB));
+}
+
+/**
+ * @brief Current state as the JSON carried by a state event
+ */
+String eventState() {
+  char json[160];
+  snprintf(json, sizeof(json),
+           "{\"effect\":\"%s\",\"blinkSpeed\":%lu,\"trainSpeed\":%lu,\"wifi\":%s,\"mqtt\":%s,\"quality\":%d}",
+           currentEffect.c_str(), blinkSpeed, christmasTrainSpeed,
+           WiFi.status() == WL_CONNECTED ? "true" : "false",
+           mqttClient.connected() ? "true" : "false", qualityLevel);
+  return String(json);
+}
+
+/**
+ * @brief Send a whole message to an event stream without waiting on the socket
+ * WiFiClient::write() keeps retrying for seconds when a browser stops reading,
+ * which would stall loop(). Here a stream that cannot take the message right
+ * now is reported as failed instead, and the caller drops it.
+ * @param client Event stream
+ * @param message Text to send
+ * @return True if all of the message was sent
+ */
+bool sseSend(WiFiClient& client, const String& message) {
+  int fd = client.fd();
+  if (fd < 0) {
+    return false;
+  }
+  fd_set writable;
+  FD_ZERO(&writable);
+  FD_SET(fd, &writable);
+  timeval timeout = {0, 0};
+  if (select(fd + 1, NULL, &writable, NULL, &timeout) <= 0) {
+    return false;
+  }
+  // A partial event would corrupt the stream, so a short send counts as failed
+  return send(fd, message.c_str(), message.length(), MSG_DONTWAIT) == (int)message.length();
+}
+
+/**
+ * @brief Open an event stream for the browser and keep its socket
+ * The response headers are written by hand because the stream never ends.
+ * The socket is taken from the server, which would otherwise wait up to 2 s
+ * for it to close and serve no other request meanwhile.
+ */
+void handleEvents() {
+  int slot = -1;
+  for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (!sseClients[i].connected()) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0) {
+    sseRefused++;
+    webServer.send(503, "text/plain", "Too many event streams\n");
+    return;
+  }
+  
+  WiFiClient client = webServer.takeClient();
+  String opening = "HTTP/1.1 200 OK\r\n"
+                   "Content-Type: text/event-stream\r\n"
+                   "Cache-Control: no-cache\r\n"
+                   "Connection: keep-alive\r\n\r\n"
+                   "retry: " + String(SSE_RETRY_MS) + "\n\n"
+                   "event: state\ndata: " + eventState() + "\n\n";
+  if (!sseSend(client, opening)) {
+    client.stop();
+    return;
+  }
+  sseEventsSent++;
+  sseClients[slot].stop();
+  sseClients[slot] = client;
+}
+
+/**
+ * @brief Push a state event to every open stream when something changed, or a heartbeat when quiet
+ */
+void updateEvents() {
+  unsigned long now = millis();
+  if (now - sseLastCheck < SSE_CHECK_MS) {
+    return;
+  }
+  sseLastCheck = now;
+  
+  uint8_t open = 0;
+  for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (sseClients[i].connected()) {
+      open++;
+    }
+  }
+  String state = eventState();
+  bool changed = state != sseLastState;
+  sseLastState = state;
+  if (open == 0 || (!changed && now - sseLastSend < SSE_HEARTBEAT_MS)) {
+    return;
+  }
+  
+  String message = changed ? "event: state\ndata: " + state + "\n\n" : String(": heartbeat\n\n");
+  for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (!sseClients[i].connected()) {
+      continue;
+    }
+    if (!sseSend(sseClients[i], message)) {
+      sseClients[i].stop();  // Browser gone or not reading; the slot is free for the next one
+    } else if (changed) {
+      sseEventsSent++;
+    }
+  }
+  sseLastSend = now;
+}
+
+/**
+ * @brief Setup web server routes and start server
+ */
+void setupWebServer() {
+  logMessage("[Web] Configuring web server...");
+  
+  // Route handlers
+  webServer.on("/", []() { timedWebHandler(WEB_ROUTE_ROOT, handleRoot); });
+  webServer.on("/cmd", []() { timedWebHandler(WEB_ROUTE_CMD, handleCommand); });
+  webServer.on("/favicon.ico", []() { timedWebHandler(WEB_ROUTE_FAVICON, handleFavicon); });
+  webServer.on("/frame", []() { timedWebHandler(WEB_ROUTE_FRAME, handleFrame); });
+  webServer.on("/events", []() { timedWebHandler(WEB_ROUTE_EVENTS, handleEvents); });
+  webServer.on("/stats", handleStats);
+  webServer.on("/coredump", handleCoredump);
+  
+  // Start server
+  webServer.begin();
+  
+  String ipAddr = WiFi.localIP().toString();
+  logMessage("[Web] ✓ Server started successfully!");
+  logMessageF("[Web] Access web interface at: http://%s", ipAddr.c_str());
+}
+
+/**
+ * @brief Give the WiFi stack and idle task a tick once the transfer has held the core for OTA_SLICE_MS
+ */
+void yieldOtaSlice() {
+  if (millis() - otaSliceStart >= OTA_SLICE_MS) {
+    vTaskDelay(1);
+    otaSliceStart = millis();
+  }
+}
+
+/**
+ * @brief Write image bytes to the inactive app partition
+ */
+bool writeOtaImage(const uint8_t* data, size_t length) {
+  if (Update.write((uint8_t*)data, length) != length) {
+    return false;
+  }
+  otaWritten += length;
+  return true;
+}
+
+/**
+ * @brief Stop writing an image and hand the error to loop()
+ * @param error ota_error_t code
+ * @param detail What went wrong
+ */
+void failOtaImage(int error, const char* detail) {
+  Serial.printf("[OTA] Update failed: %s\n", detail);
+  Update.abort();
+  otaGzip.end();
+  otaErrorDetail = detail;
+  otaError = error;
+  otaActive = false;
+}
+
+/**
+ * @brief Start writing a new image to the inactive app partition
+ * @param total Bytes expected over the network, for the progress bar (0 = unknown)
+ */
+bool beginOtaImage(unsigned int total) {
+  otaProgress = 0;
+  otaTotal = total;
+  otaWritten = 0;
+  otaGzipped = false;
+  otaFromFleet = false;
+  otaFilesystem = false;
+  otaErrorDetail = NULL;
+  otaError = -1;
+  otaStartMs = millis();
+  otaSliceStart = millis();
+  if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH)) {
+    failOtaImage(OTA_BEGIN_ERROR, Update.errorString());
+    return false;
+  }
+  otaActive = true;
+  return true;
+}
+
+/**
+ * @brief Write the next chunk of an image as received over the network
+ * An image starting with the gzip magic bytes is decompressed on the fly,
+ * so only the compressed image crosses the network and it is never held in
+ * RAM.
+ */
+bool writeOtaChunk(const uint8_t* data, size_t length) {
+  if (otaProgress == 0) {
+    otaGzipped = GzipStream::isGzip(data, length);
+    if (otaGzipped && !otaGzip.begin(writeOtaImage)) {
+      failOtaImage(OTA_BEGIN_ERROR, otaGzip.error());
+      return false;
+    }
+  }
+  bool written = otaGzipped ? otaGzip.write(data, length) : writeOtaImage(data, length);
+  if (!written) {
+    failOtaImage(OTA_RECEIVE_ERROR, otaGzipped ? otaGzip.error() : Update.errorString());
+    return false;
+  }
+  otaProgress += length;
+  yieldOtaSlice();
+  return true;
+}
+
+/**
+ * @brief Check the received image and make it the boot partition
+ * The gzip CRC32 and length are checked, then Update.end() checks the
+ * image itself before the boot partition is switched.
+ */
+bool finishOtaImage() {
+  if (otaGzipped) {
+    bool verified = otaGzip.finish();
+    otaGzip.end();
+    if (!verified) {
+      failOtaImage(OTA_RECEIVE_ERROR, otaGzip.error());
+      return false;
+    }
+  }
+  if (!Update.end(true)) {
+    failOtaImage(OTA_END_ERROR, Update.errorString());
+    return false;
+  }
+  Serial.printf("[OTA] Image complete: %u bytes received, %u written\n", otaProgress, otaWritten);
+  return true;
+}
+
+/**
+ * @brief Receive one chunk of an HTTP firmware upload
+ */
+void handleUpdateUpload() {
+  HTTPUpload& upload = updateServer.upload();
+  
+  if (upload.status == UPLOAD_FILE_START) {
+    updateRejected = !updateServer.authenticate(OTA_HTTP_USER, OTA_PASSWORD);
+    updateFailed = false;
+    if (updateRejected || otaActive) {
+      updateRejected = true;
+      return;
+    }
+    Serial.printf("[OTA] HTTP upload started: %s\n", upload.filename.c_str());
+    // size is sent by ota-update.sh for the progress bar
+    updateFailed = !beginOtaImage(updateServer.arg("size").toInt());
+  } else if (upload.status == UPLOAD_FILE_WRITE) {
+    if (!updateRejected && !updateFailed) {
+      updateFailed = !writeOtaChunk(upload.buf, upload.currentSize);
+    }
+  } else if (upload.status == UPLOAD_FILE_END) {
+    if (!updateRejected && !updateFailed) {
+      updateFailed = !finishOtaImage();
+    }
+  } else if (upload.status == UPLOAD_FILE_ABORTED) {
+    if (!updateRejected && !updateFailed) {
+      failOtaImage(OTA_RECEIVE_ERROR, "upload aborted");
+      updateFailed = true;
+    }
+  }
+}
+
+/**
+ * @brief Answer an HTTP firmware upload once it has been received
+ * loop() is told the update finished only after the reply is sent, since it
+ * reboots straight away.
+ */
+void handleUpdateDone() {
+  if (updateRejected && !updateServer.authenticate(OTA_HTTP_USER, OTA_PASSWORD)) {
+    updateServer.requestAuthentication();
+    return;
+  }
+  if (updateRejected) {
+    updateServer.send(409, "text/plain", "Update already in progress\n");
+    return;
+  }
+  if (updateFailed || !Update.isFinished()) {
+    updateServer.send(500, "text/plain", String("Update failed: ") + (otaErrorDetail ? otaErrorDetail : "no image received") + "\n");
+    return;
+  }
+  updateServer.sendHeader("Connection", "close");
+  updateServer.send(200, "text/plain", "OK - rebooting\n");
+  otaFinished = true;
+  otaActive = false;
+}
+
+/**
+ * @brief Network name of this table, e.g. IndiaTable-140808AB514C
+ */
+String deviceHostname() {
+  String hostname = "IndiaTable-" + WiFi.macAddress();
+  hostname.replace(":", "");
+  return hostname;
+}
+
+/**
+ * @brief Fetch a fleet image, check its signature and write it to the inactive partition
+ * Runs in the network task. The signature is an HMAC-SHA256 of the file as
+ * served, keyed with the OTA password, sent by the server in X-Signature.
+ * The image is only made bootable once the signature matches.
+ * @return HTTP status, or a negative HTTPClient error
+ */
+int pullUpdate() {
+  String url = String(pullUrl) + (strchr(pullUrl, '?') ? "&" : "?") +
+               "id=" + deviceHostname() + "&group=" + fleetGroup;
+  HTTPClient http;
+  const char* headers[] = {"X-Signature"};
+  if (!http.begin(url)) {
+    return -1;
+  }
+  http.collectHeaders(headers, 1);
+  int status = http.GET();
+  if (status != HTTP_CODE_OK) {
+    http.end();
+    return status;
+  }
+  
+  String signature = http.header("X-Signature");
+  int remaining = http.getSize();
+  if (signature.length() != HMAC_SHA256_BYTES * 2 || remaining <= 0) {
+    http.end();
+    otaStartMs = millis();
+    failOtaImage(OTA_BEGIN_ERROR, "fleet server sent no signature or length");
+    return status;
+  }
+  if (!beginOtaImage(remaining)) {
+    http.end();
+    return status;
+  }
+  otaFromFleet = true;
+  
+  mbedtls_md_context_t hmac;
+  mbedtls_md_init(&hmac);
+  mbedtls_md_setup(&hmac, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+  mbedtls_md_hmac_starts(&hmac, (const unsigned char*)OTA_PASSWORD, strlen(OTA_PASSWORD));
+  
+  WiFiClient* stream = http.getStreamPtr();
+  uint8_t buffer[1024];
+  unsigned long lastData = millis();
+  bool received = true;
+  while (remaining > 0) {
+    int available = stream->available();
+    if (available <= 0) {
+      if (!http.connected() || millis() - lastData > PULL_READ_TIMEOUT_MS) {
+        failOtaImage(OTA_RECEIVE_ERROR, "download stalled");
+        received = false;
+        break;
+      }
+      vTaskDelay(1);
+      continue;
+    }
+    int n = stream->read(buffer, min(available, (int)sizeof(buffer)));
+    if (n <= 0) {
+      continue;
+    }
+    lastData = millis();
+    mbedtls_md_hmac_update(&hmac, buffer, n);
+    if (!writeOtaChunk(buffer, n)) {
+      received = false;
+      break;
+    }
+    remaining -= n;
+  }
+  
+  uint8_t digest[HMAC_SHA256_BYTES];
+  mbedtls_md_hmac_finish(&hmac, digest);
+  mbedtls_md_free(&hmac);
+  http.end();
+  if (!received) {
+    return status;
+  }
+  
+  char expected[HMAC_SHA256_BYTES * 2 + 1];
+  for (uint8_t i = 0; i < HMAC_SHA256_BYTES; i++) {
+    snprintf(expected + i * 2, 3, "%02x", digest[i]);
+  }
+  if (strcasecmp(expected, signature.c_str()) != 0) {
+    failOtaImage(OTA_END_ERROR, "signature mismatch - image discarded");
+    return status;
+  }
+  if (finishOtaImage()) {
+    otaFinished = true;
+    otaActive = false;
+  }
+  return status;
+}
+
+/**
+ * @brief Try a requested fleet update, and retry later if the server's group is full
+ */
+void servicePullRequest() {
+  pullAttempts++;
+  int status = pullUpdate();
+  if (status == HTTP_CODE_SERVICE_UNAVAILABLE && pullAttempts < PULL_MAX_ATTEMPTS) {
+    Serial.printf("[OTA] Fleet server busy (attempt %u), retrying\n", pullAttempts);
+    pullRetryAt = millis() + PULL_RETRY_MS + esp_random() % 5000;
+    return;
+  }
+  if (status != HTTP_CODE_OK && otaError < 0) {
+    Serial.printf("[OTA] Fleet download failed: HTTP %d\n", status);
+    otaStartMs = millis();
+    otaErrorDetail = status < 0 ? "could not reach the fleet server"
+                   : status == HTTP_CODE_SERVICE_UNAVAILABLE ? "fleet server stayed busy"
+                   : "fleet server refused the download";
+    otaError = OTA_CONNECT_ERROR;
+  }
+  pullRequested = false;
+}
+
+/**
+ * @brief Tell the fleet server how the health check went
+ */
+void sendHealthReport() {
+  if (WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+  HTTPClient http;
+  int status = http.begin(String(healthReportUrl)) ? http.GET() : -1;
+  http.end();
+  Serial.printf("[OTA] Health report sent: HTTP %d\n", status);
+  healthReportPending = false;
+}
+
+/**
+ * @brief Open the UDP command port and the queue that feeds loop()
+ */
+void setupUdpCommands() {
+  Preferences prefs;
+  prefs.begin("udp", true);
+  udpLastSeq = prefs.getULong64("seq", 0);
+  prefs.end();
+  udpReservedSeq = udpLastSeq;
+  
+  udpQueue = xQueueCreate(UDP_QUEUE_LENGTH, sizeof(UdpCommand));
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(UDP_COMMAND_PORT);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (udpQueue == NULL || sock < 0 || bind(sock, (sockaddr*)&address, sizeof(address)) < 0) {
+    if (sock >= 0) {
+      close(sock);
+    }
+    logMessage("[UDP] ✗ Could not open the command port");
+    return;
+  }
+  udpSocket = sock;
+  logMessageF("[UDP] ✓ Command port %d ready", UDP_COMMAND_PORT);
+}
+
+/**
+ * @brief Send a short reply to a UDP sender
+ */
+void sendUdpReply(uint32_t address, uint16_t port, const char* text) {
+  sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_port = port;
+  to.sin_addr.s_addr = address;
+  sendto(udpSocket, text, strlen(text), 0, (sockaddr*)&to, sizeof(to));
+}
+
+/**
+ * @brief Check one UDP packet and queue its command for loop()
+ * Only the signature and sequence number are looked at here; the command
+ * itself is parsed by queueCommand() in loop() like any other.
+ * @return Reply for the sender
+ */
+const char* acceptUdpPacket(char* packet, int length, const sockaddr_in& from,
+                            unsigned long receivedMicros, char* reply, size_t replySize) {
+  packet[length] = '\0';
+  while (length > 0 && isspace((unsigned char)packet[length - 1])) {
+    packet[--length] = '\0';
+  }
+  char* mac = strrchr(packet, ' ');
+  if (mac == NULL || strlen(mac + 1) != HMAC_SHA256_BYTES * 2) {
+    udpRejected++;
+    return "err format";
+  }
+  *mac++ = '\0';
+  
+  uint8_t digest[HMAC_SHA256_BYTES];
+  mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                  (const unsigned char*)OTA_PASSWORD, strlen(OTA_PASSWORD),
+                  (const unsigned char*)packet, strlen(packet), digest);
+  uint8_t diff = 0;
+  char hex[3];
+  for (uint8_t i = 0; i < HMAC_SHA256_BYTES; i++) {
+    snprintf(hex, sizeof(hex), "%02x", digest[i]);
+    diff |= (hex[0] ^ tolower(mac[i * 2])) | (hex[1] ^ tolower(mac[i * 2 + 1]));
+  }
+  if (diff != 0) {
+    udpRejected++;
+    return "err auth";
+  }
+  
+  char* command;
+  uint64_t seq = strtoull(packet, &command, 10);
+  if (command == packet || *command != ' ' || strlen(command + 1) >= UDP_COMMAND_MAX) {
+    udpRejected++;
+    return "err format";
+  }
+  if (seq <= udpLastSeq) {
+    udpReplayed++;
+    return "err replay";
+  }
+  // Save a mark ahead of seq before the command can run, so after a reboot
+  // nothing accepted before it can be replayed. Every seq up to the mark was
+  // possibly used, so they are all refused then; senders move past it in
+  // at most UDP_SEQ_RESERVE.
+  if (seq > udpReservedSeq) {
+    Preferences prefs;
+    prefs.begin("udp", false);
+    prefs.putULong64("seq", seq + UDP_SEQ_RESERVE);
+    prefs.end();
+    udpReservedSeq = seq + UDP_SEQ_RESERVE;
+  }
+  
+  UdpCommand queued;
+  strcpy(queued.text, command + 1);
+  queued.seq = seq;
+  queued.address = from.sin_addr.s_addr;
+  queued.port = from.sin_port;
+  queued.receivedMicros = receivedMicros;
+  if (xQueueSend(udpQueue, &queued, 0) != pdTRUE) {
+    udpQueueFull++;
+    return "err busy";  // seq is not used up, so the sender can retry the same packet
+  }
+  udpLastSeq = seq;
+  udpAccepted++;
+  snprintf(reply, replySize, "ok %llu", (unsigned long long)seq);
+  return reply;
+}
+
+/**
+ * @brief Wait up to timeoutMs for UDP command packets and handle those that arrive
+ * Blocking in select() rather than sleeping lets a packet wake the network
+ * task at once, so it does not wait out the poll interval.
+ */
+void serviceUdpCommands(unsigned long timeoutMs) {
+  if (shownUdpPending) {
+    char reply[48];
+    snprintf(reply, sizeof(reply), "shown %llu %lu", (unsigned long long)shownUdp.seq, shownUdpMicros);
+    sendUdpReply(shownUdp.address, shownUdp.port, reply);
+    shownUdpPending = false;
+  }
+  
+  fd_set readable;
+  FD_ZERO(&readable);
+  FD_SET(udpSocket, &readable);
+  timeval timeout = {0, (long)(timeoutMs * 1000)};
+  if (select(udpSocket + 1, &readable, NULL, NULL, &timeout) <= 0) {
+    return;
+  }
+  
+  char packet[UDP_PACKET_MAX + 1];
+  char reply[48];
+  sockaddr_in from;
+  socklen_t fromLength = sizeof(from);
+  int length;
+  while ((length = recvfrom(udpSocket, packet, UDP_PACKET_MAX, MSG_DONTWAIT,
+                            (sockaddr*)&from, &fromLength)) > 0) {
+    const char* answer = acceptUdpPacket(packet, length, from, micros(), reply, sizeof(reply));
+    sendUdpReply(from.sin_addr.s_addr, from.sin_port, answer);
+    fromLength = sizeof(from);
+  }
+}
+
+/**
+ * @brief Move the next command that arrived over UDP into the pending command slot
+ * Only one per pass, and only once the slot is empty: the sender was told
+ * "ok", so the command must run rather than be replaced in the slot. The
+ * rest wait in udpQueue. The queue time counted for commandStats starts
+ * when the packet arrived.
+ */
+void receiveUdpCommands() {
+  UdpCommand received;
+  if (udpQueue == NULL || pendingCommand != "" || xQueueReceive(udpQueue, &received, 0) != pdTRUE) {
+    return;
+  }
+  if (queueCommand(String(received.text))) {
+    commandQueuedMicros = received.receivedMicros;
+    pendingUdp = received;
+    pendingFromUdp = true;
+  } else {
+    // The sender already has "ok", so tell it no frame will follow
+    char reply[48];
+    snprintf(reply, sizeof(reply), "err unknown %llu", (unsigned long long)received.seq);
+    sendUdpReply(received.address, received.port, reply);
+  }
+}
+
+/**
+ * @brief Network task body - polls for OTA uploads and receives them, and serves the UDP command port
+ * An upload is received inside ArduinoOTA.handle(), so this call can last
+ * for the whole transfer; that is why it is kept out of loop().
+ */
+void networkTask(void* param) {
+  while (true) {
+    ArduinoOTA.handle();
+    updateServer.handleClient();
+    if (pullRequested && !otaActive && (long)(millis() - pullRetryAt) >= 0) {
+      servicePullRequest();
+    }
+    if (healthReportPending) {
+      sendHealthReport();
+    }
+    if (udpSocket >= 0) {
+      serviceUdpCommands(NETWORK_TASK_POLL_MS);
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(NETWORK_TASK_POLL_MS));
+    }
+  }
+}
+
+/**
+ * @brief Start the network task on the core loop() does not use
+ */
+void startNetworkTask() {
+  if (networkTaskHandle != NULL) {
+    return;
+  }
+  if (xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK, NULL, 1,
+                              &networkTaskHandle, NETWORK_TASK_CORE) != pdPASS) {
+    networkTaskHandle = NULL;
+    logMessage("[OTA] ✗ Could not start the network task");
+    return;
+  }
+  logMessageF("[OTA] Network task running on core %d", NETWORK_TASK_CORE);
+}
+
+/**
+ * @brief Setup and configure OTA (Over-The-Air) updates
+ */
+void setupOTA() {
+  Serial.println();  // Add blank line to console
+  logMessage("[OTA] Configuring Over-The-Air updates...");
+  
+  // Set OTA hostname
+  String hostname = deviceHostname();
+  ArduinoOTA.setHostname(hostname.c_str());
+  logMessageF("[OTA] Hostname: %s", hostname.c_str());
+  
+  // Set OTA password for security
+  ArduinoOTA.setPassword(OTA_PASSWORD);
+  logMessage("[OTA] Password protection enabled");
+  
+  // Configure OTA callbacks (these run in the network task - no logMessage here)
+  ArduinoOTA.onStart([]() {
+    Serial.printf("[OTA] Update started: %s\n", ArduinoOTA.getCommand() == U_FLASH ? "sketch" : "filesystem");
+    otaProgress = 0;
+    otaTotal = 0;
+    otaWritten = 0;
+    otaGzipped = false;
+    otaFromFleet = false;
+    otaFilesystem = ArduinoOTA.getCommand() != U_FLASH;
+    otaErrorDetail = NULL;
+    otaError = -1;
+    otaStartMs = millis();
+    otaSliceStart = millis();
+    otaActive = true;
+  });
+  
+  ArduinoOTA.onEnd([]() {
+    Serial.println("[OTA] Update completed successfully!");
+    otaFinished = true;
+    otaActive = false;
+  });
+  
+  ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
+    otaProgress = progress;
+    otaTotal = total;
+    otaWritten = progress;
+    yieldOtaSlice();
+  });
+  
+  ArduinoOTA.onError([](ota_error_t error) {
+    Serial.printf("[OTA] Error[%u]\n", error);
+    otaError = error;
+    otaActive = false;
+  });
+  
+  // loop() reports the update before rebooting
+  ArduinoOTA.setRebootOnSuccess(false);
+  ArduinoOTA.begin();
+  
+  // HTTP upload for compressed images
+  updateServer.on("/update", HTTP_POST, handleUpdateDone, handleUpdateUpload);
+  updateServer.begin();
+  
+  logMessage("[OTA] ✓ Ready for firmware updates");
+  logMessageF("[OTA] IP Address: %s", WiFi.localIP().toString().c_str());
+  logMessageF("[OTA] Compressed uploads: http://%s:%d/update", WiFi.localIP().toString().c_str(), OTA_HTTP_PORT);
+  
+  startNetworkTask();
+}
+
+/**
+ * @brief Name of an OTA error code
+ */
+const char* otaErrorName(int error) {
+  switch (error) {
+    case OTA_AUTH_ERROR: return "Authentication Failed";
+    case OTA_BEGIN_ERROR: return "Begin Failed";
+    case OTA_CONNECT_ERROR: return "Connect Failed";
+    case OTA_RECEIVE_ERROR: return "Receive Failed";
+    case OTA_END_ERROR: return "End Failed";
+    default: return "Unknown Error";
+  }
+}
+
+/**
+ * @brief Record that the image just written must pass the health check on its first boots
+ * The shedding level the running image had is kept too, so a table whose
+ * strip never fits the frame budget does not fail every new image for it.
+ */
+void markUpdatePending() {
+  Preferences prefs;
+  prefs.begin("ota", false);
+  prefs.putBool("pending", true);
+  prefs.putUChar("boots", 0);
+  prefs.putBool("fleet", otaFromFleet);
+  prefs.putUChar("quality", otaStartQuality);
+  prefs.end();
+}
+
+/**
+ * @brief Queue a health check result for the fleet server that sent the image
+ * @param ok Whether the image passed
+ * @param reason Short word saying why ("ok", "mqtt", "frames", "reboots", "manual")
+ */
+void queueHealthReport(bool ok, const char* reason) {
+  Preferences prefs;
+  prefs.begin("ota", true);
+  String server = prefs.getString("server", "");
+  prefs.end();
+  if (server == "") {
+    return;
+  }
+  snprintf(healthReportUrl, sizeof(healthReportUrl), "%s/health?id=%s&group=%s&version=%s&ok=%d&reason=%s",
+           server.c_str(), deviceHostname().c_str(), fleetGroup, FIRMWARE_VERSION, ok ? 1 : 0, reason);
+  healthReportPending = true;
+}
+
+/**
+ * @brief Boot the image in the other app partition
+ * That is the image that ran before the last update. Fails if it does not
+ * hold a valid image, e.g. on a board that has only ever been flashed over
+ * serial.
+ * @param reason Short word saying why, sent to the fleet server
+ */
+void rollbackFirmware(const char* reason) {
+  const esp_partition_t* previous = esp_ota_get_next_update_partition(NULL);
+  esp_err_t err = previous != NULL ? esp_ota_set_boot_partition(previous) : ESP_FAIL;
+  
+  Preferences prefs;
+  prefs.begin("ota", false);
+  prefs.putBool("pending", false);
+  if (err == ESP_OK && prefs.getBool("fleet", false)) {
+    prefs.putString("failed", reason);  // Reported by the previous image when it boots
+  }
+  prefs.end();
+  healthCheckActive = false;
+  
+  if (err != ESP_OK) {
+    logMessageF("[OTA] ✗ Cannot roll back (%s): no valid image in the other partition", reason);
+    return;
+  }
+  logMessageF("[OTA] Rolling back to the image in %s (%s)", previous->label, reason);
+  delay(100);
+  ESP.restart();
+}
+
+/**
+ * @brief Start the health check if this is the first boot(s) of a new image
+ * Called early in setup(). Rolls straight back if the new image has already
+ * rebooted HEALTH_MAX_BOOTS times without passing, and queues the report of
+ * a rollback that brought this image back.
+ */
+void beginHealthCheck() {
+  Preferences prefs;
+  prefs.begin("ota", false);
+  String failed = prefs.getString("failed", "");
+  if (failed != "") {
+    prefs.remove("failed");
+  }
+  bool pending = prefs.getBool("pending", false);
+  uint8_t boots = pending ? prefs.getUChar("boots", 0) + 1 : 0;
+  if (pending) {
+    prefs.putUChar("boots", boots);
+  }
+  healthQualityLimit = max(prefs.getUChar("quality", 0), (uint8_t)(MAX_QUALITY_LEVEL - 1));
+  prefs.end();
+  
+  if (failed != "") {
+    Serial.printf("[OTA] Previous update was rolled back (%s)\n", failed.c_str());
+    queueHealthReport(false, failed.c_str());
+  }
+  if (!pending) {
+    return;
+  }
+  if (boots > HEALTH_MAX_BOOTS) {
+    rollbackFirmware("reboots");
+    return;
+  }
+  Serial.printf("[OTA] New firmware, health check started (boot %u of %d)\n", boots, HEALTH_MAX_BOOTS);
+  healthCheckActive = true;
+  healthCheckStart = millis();
+  healthySince = millis();
+}
+
+/**
+ * @brief Keep or roll back a new image - it must stay on MQTT and inside its frame budget for HEALTH_SETTLE_MS
+ * Inside the budget means short of the last shedding level, or no deeper
+ * than the previous image ran at.
+ */
+void updateHealthCheck() {
+  if (!healthCheckActive) {
+    return;
+  }
+  unsigned long now = millis();
+  bool healthy = mqttClient.connected() && qualityLevel <= healthQualityLimit;
+  if (!healthy) {
+    healthySince = now;
+  } else if (now - healthySince >= HEALTH_SETTLE_MS) {
+    healthCheckActive = false;
+    Preferences prefs;
+    prefs.begin("ota", false);
+    prefs.putBool("pending", false);
+    bool fleet = prefs.getBool("fleet", false);
+    prefs.end();
+    logMessageF("[OTA] ✓ Health check passed - keeping firmware v%s", FIRMWARE_VERSION);
+    if (fleet) {
+      queueHealthReport(true, "ok");
+    }
+    return;
+  }
+  if (now - healthCheckStart >= HEALTH_TIMEOUT_MS) {
+    rollbackFirmware(mqttClient.connected() ? "frames" : "mqtt");
+  }
+}
+
+/**
+ * @brief Load the fleet group this table belongs to
+ */
+void loadFleetConfig() {
+  Preferences prefs;
+  prefs.begin("fleet", true);
+  String group = prefs.getString("group", "default");
+  prefs.end();
+  strncpy(fleetGroup, group.c_str(), FLEET_GROUP_MAX);
+  fleetGroup[FLEET_GROUP_MAX] = '\0';
+}
+
+/**
+ * @brief Set and save the fleet group used by pullUpdate
+ * @param group Letters, digits, '-' or '_' (up to 16)
+ */
+void setGroup(const String& group) {
+  bool valid = group.length() > 0 && group.length() <= FLEET_GROUP_MAX && group != "all";
+  for (unsigned int i = 0; valid && i < group.length(); i++) {
+    char c = group[i];
+    valid = isalnum(c) || c == '-' || c == '_';
+  }
+  if (!valid) {
+    logMessageF("[OTA] Invalid group '%s'. Use up to %d letters, digits, '-' or '_' ('all' is reserved)",
+                group.c_str(), FLEET_GROUP_MAX);
+    return;
+  }
+  Preferences prefs;
+  prefs.begin("fleet", false);
+  prefs.putString("group", group);
+  prefs.end();
+  strncpy(fleetGroup, group.c_str(), FLEET_GROUP_MAX);
+  fleetGroup[FLEET_GROUP_MAX] = '\0';
+  logMessageF("[OTA] Fleet group set to %s", fleetGroup);
+}
+
+/**
+ * @brief Hand a fleet update to the network task
+ * @param spec "<group>,<url>" - ignored unless group is this table's group or "all"
+ */
+void requestPullUpdate(const String& spec) {
+  int comma = spec.indexOf(',');
+  String group = comma > 0 ? spec.substring(0, comma) : String("");
+  String url = comma > 0 ? spec.substring(comma + 1) : String("");
+  if (!url.startsWith("http://") || url.length() >= PULL_URL_MAX) {
+    logMessageF("[OTA] Invalid pullUpdate '%s'. Use 'pullUpdate:<group|all>,http://<server>/firmware'",
+                spec.c_str());
+    return;
+  }
+  if (group != "all" && group != fleetGroup) {
+    Serial.printf("[OTA] pullUpdate for group %s ignored (this table is in %s)\n", group.c_str(), fleetGroup);
+    return;
+  }
+  if (networkTaskHandle == NULL || pullRequested || otaActive || healthCheckActive) {
+    logMessage("[OTA] pullUpdate ignored - not connected, or an update or health check is in progress");
+    return;
+  }
+  
+  // The health report goes back to the server the image came from
+  int pathStart = url.indexOf('/', 7);
+  Preferences prefs;
+  prefs.begin("ota", false);
+  prefs.putString("server", pathStart > 0 ? url.substring(0, pathStart) : url);
+  prefs.end();
+  
+  strncpy(pullUrl, url.c_str(), PULL_URL_MAX - 1);
+  pullUrl[PULL_URL_MAX - 1] = '\0';
+  pullAttempts = 0;
+  pullRetryAt = millis() + esp_random() % 5000;  // Spread the fleet's first requests
+  pullRequested = true;
+  logMessageF("[OTA] Fleet update requested from %s (group %s)", pullUrl, fleetGroup);
+}
+
+/**
+ * @brief Log the transfer rate of an update and the frame rate while it ran
+ */
+void reportOta() {
+  unsigned long elapsed = millis() - otaStartMs;
+  unsigned long frames = showCount - otaStartFrames;
+  unsigned long fpsX10 = elapsed ? frames * 10000 / elapsed : 0;
+  logMessageF("[OTA] %u KB received in %lu.%lu s (%lu KB/s)",
+              otaProgress / 1024, elapsed / 1000, (elapsed / 100) % 10,
+              elapsed ? (unsigned long)((uint64_t)otaProgress * 1000 / 1024 / elapsed) : 0);
+  if (otaGzipped && otaWritten > 0) {
+    logMessageF("[OTA] gzip image: %u KB written to flash, %u%% of it sent over the network",
+                otaWritten / 1024, (unsigned)((uint64_t)otaProgress * 100 / otaWritten));
+  }
+  logMessageF("[OTA] Frame rate during the update %lu.%lu/s, before it %lu.%lu/s",
+              fpsX10 / 10, fpsX10 % 10, baselineFpsX10 / 10, baselineFpsX10 % 10);
+}
+
+/**
+ * @brief Follow an OTA update from loop() - log it, refresh the progress bar, reboot at the end
+ */
+void updateOta() {
+  if (otaActive && !otaAnnounced) {
+    otaAnnounced = true;
+    otaStartFrames = showCount;
+    otaStartQuality = qualityLevel;
+    otaShownPercent = 0;
+    logMessage("[OTA] Update started - effects keep running");
+  }
+  
+  if (otaActive) {
+    unsigned int total = otaTotal;
+    uint8_t percent = total ? (uint64_t)otaProgress * 100 / total : 0;
+    if (percent != otaShownPercent) {
+      otaShownPercent = percent;
+      if (percent % 10 == 0) {
+        logMessageF("[OTA] Progress: %u%%", percent);
+      }
+      // Redraw the bar even when no effect is showing frames
+      showStrip();
+    }
+    return;
+  }
+  
+  if (otaError >= 0) {
+    logMessageF("[OTA] Error[%d]: %s", otaError, otaErrorName(otaError));
+    if (otaErrorDetail != NULL) {
+      logMessageF("[OTA] %s", otaErrorDetail);
+      otaErrorDetail = NULL;
+    }
+    if (otaAnnounced) {
+      reportOta();
+    }
+    otaError = -1;
+    otaAnnounced = false;
+    showStrip();  // Clear the bar
+    return;
+  }
+  
+  if (otaFinished) {
+    logMessage("[OTA] Update completed successfully!");
+    reportOta();
+    if (otaFilesystem) {
+      // The firmware is unchanged, so there is nothing to check or roll back
+      logMessage("[OTA] Rebooting to mount the new filesystem image");
+    } else {
+      markUpdatePending();
+      logMessage("[OTA] Rebooting - the new image must pass a health check or it is rolled back");
+    }
+    delay(100);
+    ESP.restart();
+  }
+  
+  // Frame rate outside updates, measured over 5 s windows
+  unsigned long now = millis();
+  if (now - fpsMarkMs >= 5000) {
+    baselineFpsX10 = (showCount - fpsMarkFrames) * 10000 / (now - fpsMarkMs);
+    fpsMarkMs = now;
+    fpsMarkFrames = showCount;
+  }
+}
+
+/**
+ * @brief Scan for WiFi networks and connect to the strongest known network
+ * @return true if connection successful, false otherwise
+ */
+bool connectToStrongestKnownNetwork() {
+  Serial.println("\n[WiFi] Starting network scan...");
+  
+  // Start WiFi in station mode
+  WiFi.mode(WIFI_STA);
+  WiFi.disconnect();
+  delay(100);
+  
+  // Scan for available networks
+  int networkCount = WiFi.scanNetworks();
+  Serial.printf("[WiFi] Scan complete. Found %d networks\n", networkCount);
+  
+  if (networkCount == 0) {
+    Serial.println("[WiFi] ERROR: No networks found!");
+    return false;
+  }
+  
+  // Display all found networks
+  Serial.println("\n[WiFi] Available networks:");
+  for (int i = 0; i < networkCount; i++) {
+    Serial.printf("  %2d: %-32s | RSSI: %4d dBm | Ch: %2d | %s\n",
+                  i + 1,
+                  WiFi.SSID(i).c_str(),
+                  WiFi.RSSI(i),
+                  WiFi.channel(i),
+                  WiFi.encryptionType(i) == WIFI_AUTH_OPEN ? "Open" : "Encrypted");
+  }
+  
+  // Find the strongest known network
+  int bestNetworkIndex = -1;
+  int bestRSSI = -1000;
+  String bestSSID = "";
+  String bestPassword = "";
+  
+  Serial.println("\n[WiFi] Checking for known networks...");
+  
+  for (int i = 0; i < networkCount; i++) {
+    String scannedSSID = WiFi.SSID(i);
+    int scannedRSSI = WiFi.RSSI(i);
+    
+    // Check if this network is in our known list
+    for (int j = 0; j < numKnownNetworks; j++) {
+      if (scannedSSID.equals(knownNetworks[j].ssid)) {
+        Serial.printf("[WiFi] Found known network: %s (RSSI: %d dBm)\n", 
+                      scannedSSID.c_str(), scannedRSSI);
         
-        function setTrainSpeed() {
-            const speed = document.getElementById('trainSpeedValue').value;
-            if (speed < 50 || speed > 1000) {
-                showResponse('Train speed must be between 50 and 1000 ms', 'error');
-                return;
-            }
-            sendCommand('setTrainSpeed:' + speed);
+        if (scannedRSSI > bestRSSI) {
+          bestRSSI = scannedRSSI;
+          bestSSID = scannedSSID;
+          bestPassword = String(knownNetworks[j].password);
+          bestNetworkIndex = i;
         }
-        
-        function showResponse(message, type) {
-            const responseDiv = document.getElementById('response');
-            responseDiv.textContent = message;
-            responseDiv.className = 'status-bar ' + type;
-            responseDiv.style.display = 'block';
-            
-            if (type === 'success') {
-                setTimeout(() => {
-                    responseDiv.style.display = 'none';
-                }, 3000);
-            }
+      }
+    }
+  }
+  
+  // Clean up scan results
+  WiFi.scanDelete();
+  
+  // Check if we found a known network
+  if (bestNetworkIndex == -1) {
+    Serial.println("[WiFi] ERROR: No known networks found!");
+    return false;
+  }
+  
+  // Attempt to connect to the best network
+  Serial.printf("\n[WiFi] Connecting to strongest network: %s (RSSI: %d dBm)\n", 
+                bestSSID.c_str(), bestRSSI);
+  Serial.print("[WiFi] Connection progress: ");
+  
+  WiFi.begin(bestSSID.c_str(), bestPassword.c_str());
+  
+  int attempts = 0;
+  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
+    delay(500);
+    Serial.print(".");
+    attempts++;
+  }
+  
+  if (WiFi.status() == WL_CONNECTED) {
+    Serial.println(" SUCCESS!\n");
+    Serial.println("=================================");
+    Serial.println("[WiFi] CONNECTION ESTABLISHED");
+    Serial.println("=================================");
+    Serial.printf("SSID:        %s\n", WiFi.SSID().c_str());
+    Serial.printf("IP Address:  %s\n", WiFi.localIP().toString().c_str());
+    Serial.printf("MAC Address: %s\n", WiFi.macAddress().c_str());
+    Serial.printf("Signal:      %d dBm\n", WiFi.RSSI());
+    Serial.printf("Channel:     %d\n", WiFi.channel());
+    Serial.println("=================================\n");
+    return true;
+  } else {
+    Serial.println(" FAILED!");
+    Serial.printf("[WiFi] ERROR: Could not connect to %s\n", bestSSID.c_str());
+    return false;
+  }
+}
+
+/**
+ * @brief Render one frame of LED strip blinking
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderBlink(CRGB* strip, int count) {
+  effectState->phase = !effectState->phase;
+  
+  if (effectState->phase) {
+    // Turn all LEDs to the blink color
+    fill_solid(strip, count, blinkColor);
+  } else {
+    // Turn all LEDs off
+    fill_solid(strip, count, CRGB::Black);
+  }
+}
+
+/**
+ * @brief Render one frame of the twinkle effect
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderTwinkle(CRGB* strip, int count) {
+  // Update a few random LEDs each cycle for smooth, magical effect
+  for (int i = 0; i < shedCount(TWINKLE_LEDS_PER_UPDATE); i++) {
+    int ledIndex = effectState->rng.below(count);
+    
+    // Random decision: twinkle on, fade, or off
+    int action = effectState->rng.below(100);
+    
+    if (action < 15) {
+      // 15% chance: Light up with warm white/golden color
+      int brightness = effectState->rng.between(100, 255);
+      strip[ledIndex] = CRGB(brightness, brightness * 0.8, brightness * 0.3); // Warm golden
+    }
+    else if (action < 30) {
+      // 15% chance: Dim the LED
+      strip[ledIndex].fadeToBlackBy(64);
+    }
+    else if (action < 40) {
+      // 10% chance: Turn off completely
+      strip[ledIndex] = CRGB::Black;
+    }
+    // 60% chance: Do nothing (keep current state)
+  }
+  
+  // Fade all LEDs slightly for smooth transitions
+  fadeToBlackBy(strip, count, 8);
+}
+
+/**
+ * @brief Render one frame of the twinkle+ effect - MORE AGGRESSIVE TWINKLING!
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderTwinklePlus(CRGB* strip, int count) {
+  // Update many random LEDs each cycle for intense, aggressive effect
+  for (int i = 0; i < shedCount(TWINKLEPLUS_LEDS_PER_UPDATE); i++) {
+    int ledIndex = effectState->rng.below(count);
+    
+    // Random decision: twinkle on, fade, or off (more aggressive probabilities)
+    int action = effectState->rng.below(100);
+    
+    if (action < 30) {
+      // 30% chance: Light up with bright cool white sparkle
+      int brightness = effectState->rng.between(150, 255);  // Brighter minimum
+      strip[ledIndex] = CRGB(brightness, brightness, brightness); // Pure white sparkle
+    }
+    else if (action < 55) {
+      // 25% chance: Dim the LED dramatically
+      strip[ledIndex].fadeToBlackBy(100);  // More dramatic fade
+    }
+    else if (action < 70) {
+      // 15% chance: Turn off completely
+      strip[ledIndex] = CRGB::Black;
+    }
+    else if (action < 85) {
+      // 15% chance: Flash to maximum brightness with slight blue tint
+      strip[ledIndex] = CRGB(240, 245, 255);  // Bright cool white flash
+    }
+    // Only 15% chance: Do nothing (for more activity)
+  }
+  
+  // More aggressive fade for faster transitions
+  fadeToBlackBy(strip, count, 15);  // Increased from 8 for faster changes
+}
+
+/**
+ * @brief Render one frame of the gold effect - Shimmering gold twinkling
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderGold(CRGB* strip, int count) {
+  // Update many random LEDs each cycle for twinkling gold effect
+  for (int i = 0; i < shedCount(GOLD_LEDS_PER_UPDATE); i++) {
+    int ledIndex = effectState->rng.below(count);
+    
+    // Random decision: brighten, dim, or maintain
+    int action = effectState->rng.below(100);
+    
+    if (action < 35) {
+      // 35% chance: Brighten to full gold
+      strip[ledIndex] = CRGB(255, 180, 0);  // Bright gold
+    }
+    else if (action < 60) {
+      // 25% chance: Medium gold
+      strip[ledIndex] = CRGB(200, 140, 0);  // Medium gold
+    }
+    else if (action < 75) {
+      // 15% chance: Dim gold
+      strip[ledIndex] = CRGB(150, 100, 0);  // Dim gold
+    }
+    else if (action < 85) {
+      // 10% chance: Very bright shimmer
+      strip[ledIndex] = CRGB(255, 215, 40);  // Bright shimmering gold
+    }
+    // 15% chance: Do nothing - maintain current state
+  }
+  
+  // Gentle fade to keep the gold color present
+  fadeToBlackBy(strip, count, 8);  // Gentle fade
+}
+
+/**
+ * @brief Render one frame of the Vegas effect - WILD AND CRAZY!
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderVegas(CRGB* strip, int count) {
+  // Increment hue for rainbow cycling
+  effectState->phase += 4;
+  
+  // Choose random pattern each update
+  int pattern = effectState->rng.below(5);
+  
+  switch(pattern) {
+    case 0:
+      // Rainbow chase - section by section
+      for (int i = 0; i < count; i++) {
+        strip[i] = CHSV(effectState->phase + (i * 3), 255, 255);
+      }
+      break;
+      
+    case 1:
+      // Random color bursts
+      for (int i = 0; i < shedCount(20); i++) {
+        int ledIndex = effectState->rng.below(count);
+        strip[ledIndex] = CHSV(effectState->rng.next8(), 255, 255);
+      }
+      break;
+      
+    case 2:
+      // Sparkle madness
+      fadeToBlackBy(strip, count, 30);
+      for (int i = 0; i < shedCount(30); i++) {
+        strip[effectState->rng.below(count)] = CHSV(effectState->rng.next8(), 200, 255);
+      }
+      break;
+      
+    case 3:
+      // Solid color flash (saturated colors)
+      fill_solid(strip, count, CHSV(effectState->phase, 255, 255));
+      break;
+      
+    case 4:
+      // Dual color strobe
+      for (int i = 0; i < count; i++) {
+        if (i % 2 == 0) {
+          strip[i] = CHSV(effectState->phase, 255, 255);
+        } else {
+          strip[i] = CHSV(effectState->phase + 128, 255, 255);
         }
-    </script>
-</body>
-</html>
-)rawliteral";
+      }
+      break;
+  }
+}
+
+/**
+ * @brief Render one frame of the Valentines effect - Romantic pink and red love
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderValentines(CRGB* strip, int count) {
+  // Gentle pulsing hearts - alternating pink and red
+  uint8_t brightness = beatsin8(30, 50, 255);  // Slow breathing effect
+  for (int i = 0; i < count; i++) {
+    if (i % 2 == 0) {
+      strip[i] = CRGB(brightness, 0, brightness / 3);  // Pink
+    } else {
+      strip[i] = CRGB(brightness, 0, 0);  // Red
+    }
+  }
+}
+
+/**
+ * @brief St. Patrick's scene - Emerald wave - flowing green gradient
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderStPatricksEmeraldWave(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    uint8_t pos = (effectState->phase + i * 3) % 256;
+    if (pos < 128) {
+      // Bright green gradient
+      uint8_t brightness = 100 + pos;
+      strip[i] = CRGB(0, brightness, pos / 4);
+    } else {
+      // Dark green gradient
+      uint8_t brightness = 355 - pos;
+      strip[i] = CRGB(0, brightness, 20);
+    }
+  }
+}
+
+/**
+ * @brief St. Patrick's scene - Leprechaun gold sparkles on green
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderStPatricksGoldSparkles(CRGB* strip, int count) {
+  // Base green layer
+  fadeToBlackBy(strip, count, 3);
+  for (int i = 0; i < count; i += 3) {
+    strip[i] = CRGB(0, 120, 20);  // Deep green
+  }
+  
+  // Random gold sparkles (pot of gold!)
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    int ledIndex = effectState->rng.below(count);
+    strip[ledIndex] = CRGB(255, 180, 0);  // Gold
+  }
+}
+
+/**
+ * @brief St. Patrick's scene - Shamrock shimmer - green with white luck sparkles
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderStPatricksShimmer(CRGB* strip, int count) {
+  uint8_t brightness = beatsin8(25, 80, 200);  // Gentle breathing
+  for (int i = 0; i < count; i++) {
+    strip[i] = CRGB(0, brightness, brightness / 5);
+  }
+  
+  // Lucky white sparkles
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    strip[effectState->rng.below(count)] = CRGB(255, 255, 255);
+  }
+}
+
+/**
+ * @brief St. Patrick's scene - Rainbow to pot of gold - green/gold alternating chase
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderStPatricksGoldChase(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    uint8_t pos = (effectState->phase * 2 + i * 5) % 256;
+    if (pos < 128) {
+      // Green
+      strip[i] = CRGB(0, 200 - pos, 30);
+    } else {
+      // Gold
+      pos = pos - 128;
+      strip[i] = CRGB(200 + pos / 2, 150 + pos / 3, 0);
+    }
+  }
+}
+
+// St. Patrick's scenes: render function, duration (ms), fade (ms), parameter
+const Scene stPatricksScenes[] = {
+  {renderStPatricksEmeraldWave, 2700, 250, 0},
+  {renderStPatricksGoldSparkles, 2700, 0, 12},
+  {renderStPatricksShimmer, 2700, 250, 8},
+  {renderStPatricksGoldChase, 2700, 250, 0}
+};
+const Timeline stPatricksTimeline = TIMELINE(stPatricksScenes);
+
+/**
+ * @brief Render one frame of the St. Patrick's effect - Irish green and gold luck
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderStPatricks(CRGB* strip, int count) {
+  effectState->phase++;
+  renderTimeline(stPatricksTimeline, strip, count);
+}
+
+/**
+ * @brief Halloween scene - Flickering jack-o-lantern - pulsing orange with candle-like flickers
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderHalloweenLantern(CRGB* strip, int count) {
+  uint8_t baseBrightness = beatsin8(20, 100, 255);  // Slow pulse
+  noiseField.update(millis() / 2, 40);  // Fast time, features a few pixels wide
+  
+  for (int i = 0; i < count; i++) {
+    uint8_t flicker = scale8(255 - noiseField[i], 100);  // Dips of up to 100
+    uint8_t brightness = baseBrightness - flicker;
+    strip[i] = CRGB(brightness, brightness / 3, 0);  // Orange
+  }
+}
+
+/**
+ * @brief Halloween scene - Witch's cauldron - bubbling purple and green
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderHalloweenCauldron(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    uint8_t pos = (effectState->phase * 2 + i * 4) % 256;
+    if (pos < 128) {
+      // Purple
+      uint8_t brightness = 150 + (pos / 2);
+      strip[i] = CRGB(brightness / 2, 0, brightness);
+    } else {
+      // Eerie green
+      pos = pos - 128;
+      strip[i] = CRGB(0, 200 - pos, pos / 3);
+    }
+  }
+}
+
+/**
+ * @brief Halloween scene - Haunted house - random spooky colors appearing
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderHalloweenHauntedHouse(CRGB* strip, int count) {
+  fadeToBlackBy(strip, count, 15);
+  
+  // Random spooky lights
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    int ledIndex = effectState->rng.below(count);
+    int colorChoice = effectState->rng.below(3);
+    
+    if (colorChoice == 0) {
+      strip[ledIndex] = CRGB(255, 100, 0);   // Orange
+    } else if (colorChoice == 1) {
+      strip[ledIndex] = CRGB(128, 0, 200);   // Purple
+    } else {
+      strip[ledIndex] = CRGB(0, 255, 50);    // Eerie green
+    }
+  }
+}
+
+/**
+ * @brief Halloween scene - Ghostly apparition - floating white/green wisps
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderHalloweenGhosts(CRGB* strip, int count) {
+  // Dark base
+  for (int i = 0; i < count; i++) {
+    strip[i] = CRGB(10, 0, 20);  // Dark purple background
+  }
+  
+  // Ghostly wisps moving through
+  for (int i = 0; i < count; i++) {
+    uint8_t pos = (effectState->phase * 3 + i * 8) % 256;
+    if (pos > 200 && pos < 240) {
+      // Ghostly white-green
+      uint8_t brightness = 255 - ((pos - 200) * 6);
+      strip[i] = CRGB(brightness / 2, brightness, brightness / 2);
+    }
+  }
+}
+
+// Halloween scenes: render function, duration (ms), fade (ms), parameter
+const Scene halloweenScenes[] = {
+  {renderHalloweenLantern, 2450, 300, 0},
+  {renderHalloweenCauldron, 2450, 300, 0},
+  {renderHalloweenHauntedHouse, 2450, 0, 15},
+  {renderHalloweenGhosts, 2450, 300, 0}
+};
+const Timeline halloweenTimeline = TIMELINE(halloweenScenes);
+
+/**
+ * @brief Render one frame of the Halloween effect - Spooky orange, purple, and green
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderHalloween(CRGB* strip, int count) {
+  effectState->phase++;
+  renderTimeline(halloweenTimeline, strip, count);
+}
+
+/**
+ * @brief Render one frame of the Christmas effect - Festive red, green, white, and gold
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderChristmas(CRGB* strip, int count) {
+  effectState->phase++;
+  
+  // Classic red and green waves
+  for (int i = 0; i < count; i++) {
+    uint8_t pos = (effectState->phase * 2 + i * renderStride * 3) % 256;
+    if (pos < 128) {
+      // Festive red
+      uint8_t brightness = 150 + pos;
+      strip[i] = CRGB(brightness, 0, 0);
+    } else {
+      // Christmas green
+      uint8_t brightness = 150 + (255 - pos);
+      strip[i] = CRGB(0, brightness, 0);
+    }
+  }
+}
+
+/**
+ * @brief Render one frame of the Birthday effect - Colorful celebration with confetti and candles
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderBirthday(CRGB* strip, int count) {
+  effectState->phase++;
+  
+  // Confetti burst - random colorful sparkles
+  fadeToBlackBy(strip, count, 25);
+  
+  // Burst of colorful confetti
+  for (int i = 0; i < shedCount(25); i++) {
+    int ledIndex = effectState->rng.below(count);
+    uint8_t hue = effectState->rng.next8();  // Random rainbow colors
+    strip[ledIndex] = CHSV(hue, 255, 255);
+  }
+}
+
+/**
+ * @brief Wild Christmas scene - Crazy strobe - rapid red/green/white flashes
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderWildChristmasStrobe(CRGB* strip, int count) {
+  int flashPattern = effectState->phase % 9;
+  CRGB color;
+  
+  if (flashPattern < 3) {
+    color = CRGB(255, 0, 0);     // Bright red
+  } else if (flashPattern < 6) {
+    color = CRGB(0, 255, 0);     // Bright green
+  } else {
+    color = CRGB(255, 255, 255); // White flash
+  }
+  
+  fill_solid(strip, count, color);
+}
+
+/**
+ * @brief Wild Christmas scene - Lightning bolts - random white strikes on Christmas colors
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderWildChristmasLightning(CRGB* strip, int count) {
+  // Base alternating red/green
+  for (int i = 0; i < count; i++) {
+    if ((i + effectState->phase / 2) % 6 < 3) {
+      strip[i] = CRGB(150, 0, 0);   // Red
+    } else {
+      strip[i] = CRGB(0, 150, 0);   // Green
+    }
+  }
+  
+  // Random lightning strikes
+  if (effectState->rng.next8() > 180) {
+    int strikePos = effectState->rng.below(count);
+    int strikeLen = effectState->rng.between(20, 60);
+    for (int i = 0; i < strikeLen && (strikePos + i) < count; i++) {
+      strip[strikePos + i] = CRGB(255, 255, 255);
+    }
+  }
+}
+
+/**
+ * @brief Wild Christmas scene - Spinning Christmas chaos - fast rotating segments
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderWildChristmasChaos(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    int segment = ((i + effectState->phase * 4) / 20) % 5;
+    
+    switch(segment) {
+      case 0:
+        strip[i] = CRGB(255, 0, 0);      // Red
+        break;
+      case 1:
+        strip[i] = CRGB(0, 255, 0);      // Green
+        break;
+      case 2:
+        strip[i] = CRGB(255, 255, 255);  // White
+        break;
+      case 3:
+        strip[i] = CRGB(200, 150, 0);    // Gold
+        break;
+      case 4:
+        strip[i] = CRGB(0, 100, 200);    // Ice blue
+        break;
+    }
+  }
+}
+
+/**
+ * @brief Wild Christmas scene - Explosive sparkles - bursting Christmas colors everywhere
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderWildChristmasSparkles(CRGB* strip, int count) {
+  fadeToBlackBy(strip, count, 40);
+  
+  // Massive sparkle explosions
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    int ledIndex = effectState->rng.below(count);
+    int colorChoice = effectState->rng.below(5);
+    
+    CRGB sparkleColor;
+    switch(colorChoice) {
+      case 0:
+        sparkleColor = CRGB(255, 0, 0);      // Red
+        break;
+      case 1:
+        sparkleColor = CRGB(0, 255, 0);      // Green
+        break;
+      case 2:
+        sparkleColor = CRGB(255, 255, 255);  // White
+        break;
+      case 3:
+        sparkleColor = CRGB(255, 200, 0);    // Gold
+        break;
+      case 4:
+        sparkleColor = CRGB(100, 200, 255);  // Ice blue
+        break;
+    }
+    
+    strip[ledIndex] = sparkleColor;
+  }
+}
+
+// Wild Christmas scenes: render function, duration (ms), fade (ms), parameter
+const Scene wildChristmasScenes[] = {
+  {renderWildChristmasStrobe, 2250, 0, 0},
+  {renderWildChristmasLightning, 2250, 0, 0},
+  {renderWildChristmasChaos, 2250, 0, 0},
+  {renderWildChristmasSparkles, 2250, 0, 35}
+};
+const Timeline wildChristmasTimeline = TIMELINE(wildChristmasScenes);
+
+/**
+ * @brief Render one frame of the Wild Christmas effect - Fast chaotic Christmas party mode
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderWildChristmas(CRGB* strip, int count) {
+  effectState->phase++;
+  renderTimeline(wildChristmasTimeline, strip, count);
+}
+
+/**
+ * @brief Render one frame of the Christmas Basic effect - Red, Green, White alternating with twinkling
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderChristmasBasic(CRGB* strip, int count) {
+  // Update random LEDs for twinkling effect
+  for (int i = 0; i < shedCount(15); i++) {  // Update 15 random LEDs each cycle
+    int ledIndex = effectState->rng.below(count);
+    
+    // Determine base color for this LED position
+    int colorIndex = ledIndex % 3;
+    CRGB baseColor;
+    if (colorIndex == 0) {
+      baseColor = CRGB::Red;
+    } else if (colorIndex == 1) {
+      baseColor = CRGB::Green;
+    } else {
+      baseColor = CRGB::White;
+    }
+    
+    // Random twinkle action
+    int action = effectState->rng.below(100);
+    
+    if (action < 20) {
+      // 20% chance: Brighten to full brightness (twinkle on)
+      strip[ledIndex] = baseColor;
+    }
+    else if (action < 40) {
+      // 20% chance: Dim the LED noticeably
+      strip[ledIndex] = baseColor;
+      strip[ledIndex].fadeToBlackBy(100);  // Dim to about 60% brightness
+    }
+    else if (action < 50) {
+      // 10% chance: Very dim (almost off but noticeable)
+      strip[ledIndex] = baseColor;
+      strip[ledIndex].fadeToBlackBy(200);  // Dim to about 22% brightness
+    }
+    // 50% chance: Do nothing - maintain current state for persistence
+  }
+  
+  // Gentle overall fade to create breathing/twinkling effect
+  fadeToBlackBy(strip, count, 3);  // Very subtle fade
+}
+
+/**
+ * @brief Render one frame of the Christmas Train effect - Rotating red, green, white pattern
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderChristmasTrain(CRGB* strip, int count) {
+  // Increment offset to create rotation effect
+  effectState->phase++;
+  if (effectState->phase >= 3) {
+    effectState->phase = 0;  // Reset after full color cycle
+  }
+  
+  // Update all LEDs with rotated pattern
+  for (int i = 0; i < count; i++) {
+    int colorIndex = (i + effectState->phase) % 3;
+    if (colorIndex == 0) {
+      strip[i] = CRGB::Red;
+    } else if (colorIndex == 1) {
+      strip[i] = CRGB::Green;
+    } else {
+      strip[i] = CRGB::White;
+    }
+  }
+}
+
+/**
+ * @brief Rainbow scene - Classic flowing rainbow wave
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderRainbowWave(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    uint8_t hue = (effectState->phase * 2 + i * renderStride * 2) % 256;
+    strip[i] = CHSV(hue, 255, 255);
+  }
+}
+
+/**
+ * @brief Rainbow scene - Rainbow pulse - breathing full spectrum
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderRainbowPulse(CRGB* strip, int count) {
+  uint8_t brightness = beatsin8(20, 100, 255);
+  
+  for (int i = 0; i < count; i++) {
+    uint8_t hue = (i * renderStride * 3) % 256;
+    strip[i] = CHSV(hue, 255, brightness);
+  }
+}
+
+/**
+ * @brief Rainbow scene - Rainbow segments - distinct color blocks moving
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderRainbowSegments(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    uint8_t segment = ((i * renderStride + effectState->phase * 2) / 30) % 7;
+    uint8_t hue = segment * 36;  // 7 colors evenly spaced around hue wheel
+    strip[i] = CHSV(hue, 255, 255);
+  }
+}
+
+/**
+ * @brief Rainbow scene - Rainbow sparkle - twinkling multi-color
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderRainbowSparkle(CRGB* strip, int count) {
+  fadeToBlackBy(strip, count, 15);
+  
+  // Add rainbow sparkles
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    int ledIndex = effectState->rng.below(count);
+    uint8_t hue = effectState->rng.next8();
+    strip[ledIndex] = CHSV(hue, 255, 255);
+  }
+}
+
+// Rainbow scenes: render function, duration (ms), fade (ms), parameter
+const Scene rainbowScenes[] = {
+  {renderRainbowWave, 2400, 250, 0},
+  {renderRainbowPulse, 2400, 250, 0},
+  {renderRainbowSegments, 2400, 250, 0},
+  {renderRainbowSparkle, 2400, 0, 20}
+};
+const Timeline rainbowTimeline = TIMELINE(rainbowScenes);
+
+/**
+ * @brief Render one frame of the Rainbow effect - Smooth spectrum animations
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderRainbow(CRGB* strip, int count) {
+  effectState->phase++;
+  renderTimeline(rainbowTimeline, strip, count);
+}
+
+/**
+ * @brief Lightsaber duel choreography - ignite, trade strikes, retract
+ * @param f Duel state
+ * @param count Number of LEDs in the buffer
+ */
+void duelThread(DuelFrame* f, int count) {
+  EFFECT_BEGIN(&f->thread);
+  
+  // Ignite both blades out of the middle of the strip
+  f->clash = count / 2;
+  f->flash = 0;
+  for (f->blade = 0; f->blade < 30; f->blade += 3) {
+    EFFECT_NEXT_FRAME(&f->thread);
+  }
+  
+  // Push the clash point back and forth, flashing on each strike
+  for (f->strikes = 4; f->strikes > 0; f->strikes--) {
+    f->target = effectState->rng.between(count / 4, count * 3 / 4);
+    while (abs(f->clash - f->target) > 4) {
+      f->clash += f->clash < f->target ? 4 : -4;
+      EFFECT_NEXT_FRAME(&f->thread);
+    }
+    f->flash = 6;
+    EFFECT_SLEEP_MS(&f->thread, 120);
+    f->flash = 3;
+    EFFECT_SLEEP_MS(&f->thread, 200);
+  }
+  
+  // Retract and pause before the next bout
+  f->flash = 0;
+  while (f->blade > 0) {
+    f->blade -= 3;
+    EFFECT_NEXT_FRAME(&f->thread);
+  }
+  EFFECT_SLEEP_MS(&f->thread, 400);
+  
+  EFFECT_END(&f->thread);
+}
+
+/**
+ * @brief Draw the blades and clash flash for the duel's current state
+ * @param f Duel state
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void drawDuel(const DuelFrame* f, CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    int distance = abs(i - f->clash);
+    if (distance < f->blade) {
+      uint8_t brightness = 255 - (distance * 8);
+      if (i < f->clash) {
+        strip[i] = CRGB(brightness / 4, brightness / 4, brightness);  // Blue lightsaber (Jedi)
+      } else {
+        strip[i] = CRGB(brightness, brightness / 8, brightness / 8);  // Red lightsaber (Sith)
+      }
+    } else {
+      strip[i] = CRGB(0, 0, 0);
+    }
+  }
+  
+  // Clash point - white flash
+  for (int i = -f->flash; i <= f->flash; i++) {
+    int pos = f->clash + i;
+    if (pos >= 0 && pos < count) {
+      strip[pos] = CRGB(255, 255, 255);
+    }
+  }
+}
+
+/**
+ * @brief May The 4th scene - Lightsaber duel - blue vs red clashing
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderMayThe4thDuel(CRGB* strip, int count) {
+  DuelFrame* f = effectFrame(duelFrame);
+  if (f == NULL) {
+    return;
+  }
+  duelThread(f, count);
+  drawDuel(f, strip, count);
+}
+
+/**
+ * @brief May The 4th scene - Hyperspace jump - streaking blue and white
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderMayThe4thHyperspace(CRGB* strip, int count) {
+  fadeToBlackBy(strip, count, 50);
+  
+  // Create hyperspace streaks
+  for (int i = 0; i < shedCount(15); i++) {
+    int streakStart = (effectState->phase * 6 + i * 60) % count;
+    int streakLength = 20;
+    
+    for (int j = 0; j < streakLength; j++) {
+      int pos = (streakStart + j) % count;
+      uint8_t brightness = 255 - (j * 12);
+      if (i % 2 == 0) {
+        strip[pos] = CRGB(brightness / 2, brightness / 2, brightness);  // Blue streak
+      } else {
+        strip[pos] = CRGB(brightness, brightness, brightness);  // White streak
+      }
+    }
+  }
+}
+
+/**
+ * @brief May The 4th scene - Death Star tractor beam - pulsing green beams
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderMayThe4thTractorBeam(CRGB* strip, int count) {
+  // Space background
+  for (int i = 0; i < count; i++) {
+    strip[i] = CRGB(2, 2, 5);  // Dark space
+  }
   
-  webServer.send(200, "text/html", html);
+  // Starfield twinkle
+  if (effectState->rng.next8() > 200) {
+    int star = effectState->rng.below(count);
+    strip[star] = CRGB(255, 255, 255);
+  }
+  
+  // Pulsing green tractor beams
+  uint8_t beamBrightness = beatsin8(25, 50, 255);
+  for (int i = 0; i < count; i += 50) {
+    int beamCenter = (i + effectState->phase) % count;
+    
+    for (int j = -8; j <= 8; j++) {
+      int pos = beamCenter + j;
+      if (pos >= 0 && pos < count) {
+        uint8_t brightness = beamBrightness - (abs(j) * 15);
+        strip[pos] = CRGB(0, brightness, brightness / 3);
+      }
+    }
+  }
 }
 
 /**
- * @brief Handle command requests from web interface
+ * @brief May The 4th scene - Force energy - alternating Jedi blue/green and Sith red
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
  */
-void handleCommand() {
-  if (webServer.hasArg("command")) {
-    String command = webServer.arg("command");
-    pendingCommand = command;
+void renderMayThe4thForce(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    uint8_t wave = sin8((effectState->phase * 2 + i * 4) % 256);
     
-    String response = "Command received: " + command;
-    logMessage("[Web] " + response);
-    webServer.send(200, "text/plain", response);
-  } else {
-    webServer.send(400, "text/plain", "Missing command parameter");
+    if (wave < 128) {
+      // Light side - blue/green Force energy
+      uint8_t brightness = wave * 2;
+      if (i % 2 == 0) {
+        strip[i] = CRGB(brightness / 4, brightness / 2, brightness);  // Blue
+      } else {
+        strip[i] = CRGB(brightness / 4, brightness, brightness / 4);  // Green
+      }
+    } else {
+      // Dark side - red Force lightning
+      uint8_t brightness = (255 - wave) * 2;
+      strip[i] = CRGB(brightness, brightness / 8, 0);
+    }
   }
 }
 
+// May The 4th scenes: render function, duration (ms), fade (ms), parameter
+const Scene mayThe4thScenes[] = {
+  {renderMayThe4thDuel, 2625, 0, 0},
+  {renderMayThe4thHyperspace, 2625, 0, 0},
+  {renderMayThe4thTractorBeam, 2625, 0, 0},
+  {renderMayThe4thForce, 2625, 0, 0}
+};
+const Timeline mayThe4thTimeline = TIMELINE(mayThe4thScenes);
+
 /**
- * @brief Setup web server routes and start server
+ * @brief Render one frame of the May The 4th effect - Star Wars themed animations
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
  */
-void setupWebServer() {
-  logMessage("[Web] Configuring web server...");
-  
-  // Route handlers
-  webServer.on("/", handleRoot);
-  webServer.on("/cmd", handleCommand);
-  webServer.on("/favicon.ico", []() {
-    webServer.send_P(200, "image/x-icon", (const char*)favicon_ico, favicon_ico_len);
-  });
-  
-  // Start server
-  webServer.begin();
+void renderMayThe4th(CRGB* strip, int count) {
+  effectState->phase++;
+  renderTimeline(mayThe4thTimeline, strip, count);
+}
+
+/**
+ * @brief Canada Day scene - Maple leaf stripes - alternating red and white bands
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderCanadaDayStripes(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    uint8_t pos = (effectState->phase + i * 5) % 100;
+    if (pos < 50) {
+      // Canadian red
+      strip[i] = CRGB(255, 0, 0);
+    } else {
+      // Pure white
+      strip[i] = CRGB(255, 255, 255);
+    }
+  }
+}
+
+/**
+ * @brief Canada Day scene - Northern lights shimmer - red and white aurora
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderCanadaDayAurora(CRGB* strip, int count) {
+  noiseField.update(millis() / 8, 12);  // Slow drift, wide curtains
   
-  String ipAddr = WiFi.localIP().toString();
-  logMessage("[Web] ✓ Server started successfully!");
-  logMessageF("[Web] Access web interface at: http://%s", ipAddr.c_str());
+  for (int i = 0; i < count; i++) {
+    uint8_t wave1 = sin8((effectState->phase * 2 + i * 3) % 256);
+    uint8_t wave2 = noiseField[i];
+    
+    if (wave1 > wave2) {
+      // Red shimmer
+      uint8_t brightness = (wave1 + wave2) / 2;
+      strip[i] = CRGB(brightness, brightness / 8, brightness / 8);
+    } else {
+      // White shimmer
+      uint8_t brightness = (wave1 + wave2) / 2;
+      strip[i] = CRGB(brightness, brightness, brightness);
+    }
+  }
 }
 
 /**
- * @brief Setup and configure OTA (Over-The-Air) updates
+ * @brief Firework choreography - a burst spreads over a few frames, then a random pause
+ * @param f Burst state
+ * @param count Number of LEDs in the buffer
  */
-void setupOTA() {
-  Serial.println();  // Add blank line to console
-  logMessage("[OTA] Configuring Over-The-Air updates...");
+void burstThread(BurstFrame* f, int count) {
+  EFFECT_BEGIN(&f->thread);
   
-  // Set OTA hostname
-  String hostname = "IndiaTable-" + WiFi.macAddress();
-  hostname.replace(":", "");
-  ArduinoOTA.setHostname(hostname.c_str());
-  logMessageF("[OTA] Hostname: %s", hostname.c_str());
+  f->center = effectState->rng.below(count);
+  f->red = effectState->rng.next8() > 127;
+  for (f->radius = 4; f->radius <= 20; f->radius += 4) {
+    EFFECT_NEXT_FRAME(&f->thread);
+  }
+  f->radius = 0;
+  EFFECT_SLEEP_MS(&f->thread, 300 + effectState->rng.below(400));
   
-  // Set OTA password for security
-  ArduinoOTA.setPassword(OTA_PASSWORD);
-  logMessage("[OTA] Password protection enabled");
+  EFFECT_END(&f->thread);
+}
+
+/**
+ * @brief Canada Day scene - Fireworks burst - red and white explosions
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderCanadaDayFireworks(CRGB* strip, int count) {
+  fadeToBlackBy(strip, count, 20);
   
-  // Configure OTA callbacks
-  ArduinoOTA.onStart([]() {
-    String type;
-    if (ArduinoOTA.getCommand() == U_FLASH) {
-      type = "sketch";
-    } else {  // U_SPIFFS
-      type = "filesystem";
+  BurstFrame* f = effectFrame(burstFrame);
+  if (f != NULL) {
+    burstThread(f, count);
+    
+    // Burst pattern - spreads out from the centre, dimmer towards the edge
+    for (int i = -f->radius; i <= f->radius && f->radius > 0; i++) {
+      int pos = f->center + i;
+      if (pos >= 0 && pos < count) {
+        uint8_t brightness = 255 - (abs(i) * 10);
+        if (f->red) {
+          strip[pos] = CRGB(brightness, 0, 0);
+        } else {
+          strip[pos] = CRGB(brightness, brightness, brightness);
+        }
+      }
     }
-    logMessageF("[OTA] Update started: %s", type.c_str());
-  });
+  }
   
-  ArduinoOTA.onEnd([]() {
-    logMessage("[OTA] Update completed successfully!");
-    logMessage("[OTA] Rebooting...");
-  });
+  // Sparkles
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    int ledIndex = effectState->rng.below(count);
+    if (effectState->rng.next8() > 127) {
+      strip[ledIndex] = CRGB(255, 0, 0);        // Red sparkle
+    } else {
+      strip[ledIndex] = CRGB(255, 255, 255);    // White sparkle
+    }
+  }
+}
+
+/**
+ * @brief Canada Day scene - Flag wave - flowing red/white/red pattern
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderCanadaDayFlagWave(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    // Create three sections like the Canadian flag
+    uint8_t section = ((i + effectState->phase * 2) * 3 / count);
+    uint8_t wave = beatsin8(20, 150, 255, 0, i * 2);
+    
+    if (section == 0 || section == 2) {
+      // Red sections (left and right of flag)
+      strip[i] = CRGB(wave, 0, 0);
+    } else {
+      // White center section (where maple leaf would be)
+      // Add slight red tint for maple leaf suggestion
+      uint8_t maple = sin8((effectState->phase * 4 + i * 8) % 256);
+      if (maple > 200) {
+        strip[i] = CRGB(wave, wave / 4, wave / 4);  // Red maple highlight
+      } else {
+        strip[i] = CRGB(wave, wave, wave);  // White background
+      }
+    }
+  }
+}
+
+// Canada Day scenes: render function, duration (ms), fade (ms), parameter
+const Scene canadaDayScenes[] = {
+  {renderCanadaDayStripes, 2800, 250, 0},
+  {renderCanadaDayAurora, 2800, 250, 0},
+  {renderCanadaDayFireworks, 2800, 0, 15},
+  {renderCanadaDayFlagWave, 2800, 250, 0}
+};
+const Timeline canadaDayTimeline = TIMELINE(canadaDayScenes);
+
+/**
+ * @brief Render one frame of the Canada Day effect - Red and white patriotic Canadian celebration
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderCanadaDay(CRGB* strip, int count) {
+  effectState->phase++;
+  renderTimeline(canadaDayTimeline, strip, count);
+}
+
+/**
+ * @brief New Years scene - Champagne bubbles - rising gold and silver sparkles
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderNewYearsBubbles(CRGB* strip, int count) {
+  fadeToBlackBy(strip, count, 20);
   
-  ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
-    static unsigned int lastPercent = 0;
-    unsigned int percent = (progress / (total / 100));
-    if (percent != lastPercent && percent % 10 == 0) {
-      Serial.printf("[OTA] Progress: %u%%\n", percent);
-      lastPercent = percent;
+  // Rising bubbles effect
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    int ledIndex = effectState->rng.below(count);
+    bool isGold = effectState->rng.next8() > 127;
+    
+    if (isGold) {
+      strip[ledIndex] = CRGB(255, 200, 0);      // Gold bubble
+    } else {
+      strip[ledIndex] = CRGB(220, 220, 255);    // Silver/white bubble
     }
-  });
+  }
+}
+
+/**
+ * @brief New Years scene - Countdown sparkle - alternating gold and silver waves
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderNewYearsCountdown(CRGB* strip, int count) {
+  for (int i = 0; i < count; i++) {
+    uint8_t pos = (effectState->phase * 3 + i * 2) % 256;
+    if (pos < 128) {
+      // Gold wave
+      uint8_t brightness = 150 + pos;
+      strip[i] = CRGB(brightness, brightness * 0.7, 0);
+    } else {
+      // Silver wave
+      uint8_t brightness = 150 + (255 - pos);
+      strip[i] = CRGB(brightness * 0.8, brightness * 0.8, brightness);
+    }
+  }
+}
+
+/**
+ * @brief New Years scene - Fireworks burst - colorful explosions
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderNewYearsFireworks(CRGB* strip, int count) {
+  fadeToBlackBy(strip, count, 15);
   
-  ArduinoOTA.onError([](ota_error_t error) {
-    Serial.printf("[OTA] Error[%u]: ", error);
-    if (error == OTA_AUTH_ERROR) {
-      logMessage("Authentication Failed");
-    } else if (error == OTA_BEGIN_ERROR) {
-      logMessage("Begin Failed");
-    } else if (error == OTA_CONNECT_ERROR) {
-      logMessage("Connect Failed");
-    } else if (error == OTA_RECEIVE_ERROR) {
-      logMessage("Receive Failed");
-    } else if (error == OTA_END_ERROR) {
-      logMessage("End Failed");
+  // Create firework bursts
+  if (effectState->phase % 12 == 0) {
+    int burstCenter = effectState->rng.below(count);
+    uint8_t hue = effectState->rng.next8();  // Random color
+    
+    // Burst pattern
+    for (int i = -25; i <= 25; i++) {
+      int pos = burstCenter + i;
+      if (pos >= 0 && pos < count) {
+        uint8_t brightness = 255 - (abs(i) * 8);
+        strip[pos] = CHSV(hue, 255, brightness);
+      }
     }
-  });
+  }
   
-  ArduinoOTA.begin();
-  logMessage("[OTA] ✓ Ready for firmware updates");
-  logMessageF("[OTA] IP Address: %s", WiFi.localIP().toString().c_str());
+  // Add sparkles
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    int ledIndex = effectState->rng.below(count);
+    uint8_t sparkleHue = effectState->rng.next8();
+    strip[ledIndex] = CHSV(sparkleHue, 255, 255);
+  }
 }
 
 /**
- * @brief Scan for WiFi networks and connect to the strongest known network
- * @return true if connection successful, false otherwise
+ * @brief New Years scene - Confetti celebration - rapid multicolor bursts
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
  */
-bool connectToStrongestKnownNetwork() {
-  Serial.println("\n[WiFi] Starting network scan...");
-  
-  // Start WiFi in station mode
-  WiFi.mode(WIFI_STA);
-  WiFi.disconnect();
-  delay(100);
+void renderNewYearsConfetti(CRGB* strip, int count) {
+  fadeToBlackBy(strip, count, 30);
   
-  // Scan for available networks
-  int networkCount = WiFi.scanNetworks();
-  Serial.printf("[WiFi] Scan complete. Found %d networks\n", networkCount);
+  // Intense confetti burst
+  for (int i = 0; i < shedCount(sceneParam); i++) {
+    int ledIndex = effectState->rng.below(count);
+    uint8_t colorChoice = effectState->rng.below(5);
+    
+    switch(colorChoice) {
+      case 0:
+        strip[ledIndex] = CRGB(255, 200, 0);    // Gold
+        break;
+      case 1:
+        strip[ledIndex] = CRGB(220, 220, 255);  // Silver
+        break;
+      case 2:
+        strip[ledIndex] = CRGB(255, 0, 100);    // Pink
+        break;
+      case 3:
+        strip[ledIndex] = CRGB(0, 200, 255);    // Cyan
+        break;
+      case 4:
+        strip[ledIndex] = CRGB(150, 0, 255);    // Purple
+        break;
+    }
+  }
+}
+
+// New Years scenes: render function, duration (ms), fade (ms), parameter
+const Scene newYearsScenes[] = {
+  {renderNewYearsBubbles, 2625, 0, 30},
+  {renderNewYearsCountdown, 2625, 0, 0},
+  {renderNewYearsFireworks, 2625, 0, 20},
+  {renderNewYearsConfetti, 2625, 0, 35}
+};
+const Timeline newYearsTimeline = TIMELINE(newYearsScenes);
+
+/**
+ * @brief Render one frame of the New Years effect - Gold, silver, and colorful celebration
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderNewYears(CRGB* strip, int count) {
+  effectState->phase++;
+  renderTimeline(newYearsTimeline, strip, count);
+}
+
+/**
+ * @brief Render one frame of the Candy Cane effect - Red and white stripes
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderCandyCane(CRGB* strip, int count) {
+  effectState->phase++;
   
-  if (networkCount == 0) {
-    Serial.println("[WiFi] ERROR: No networks found!");
-    return false;
+  // Candy cane stripes - red and white
+  for (int i = 0; i < count; i++) {
+    // Diagonal stripes from the table layout so they line up across corners
+    uint8_t pos = (effectState->phase + (pixelAt(i).x + pixelAt(i).y) * 3) % 80;
+    if (pos < 40) {
+      // Bright red stripe
+      strip[i] = CRGB(255, 0, 0);
+    } else {
+      // Pure white stripe
+      strip[i] = CRGB(255, 255, 255);
+    }
+  }
+}
+
+/**
+ * @brief Render one frame of the Serene effect - Gentle Christmas palette sparkles
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderSerene(CRGB* strip, int count) {
+  // Gentle global fade - keep a soft tail
+  for (int i = 0; i < count; i++) {
+    strip[i].nscale8(230);
   }
   
-  // Display all found networks
-  Serial.println("\n[WiFi] Available networks:");
-  for (int i = 0; i < networkCount; i++) {
-    Serial.printf("  %2d: %-32s | RSSI: %4d dBm | Ch: %2d | %s\n",
-                  i + 1,
-                  WiFi.SSID(i).c_str(),
-                  WiFi.RSSI(i),
-                  WiFi.channel(i),
-                  WiFi.encryptionType(i) == WIFI_AUTH_OPEN ? "Open" : "Encrypted");
+  // Christmas palette seeds: warm white, soft red, soft green, gold
+  const CRGB palette[] = {
+    CRGB(255, 240, 200), // warm white
+    CRGB(200, 30, 30),   // soft red
+    CRGB(20, 160, 40),   // soft green
+    CRGB(230, 180, 40)   // gold
+  };
+  
+  // Seed a few random pixels
+  uint8_t seeds = 3 + effectState->rng.below(3); // 3-5 sparks per frame
+  for (uint8_t s = 0; s < seeds; s++) {
+    int idx = effectState->rng.below(count);
+    CRGB base = palette[effectState->rng.below(sizeof(palette) / sizeof(palette[0]))];
+    uint8_t boost = 140 + effectState->rng.below(115); // brightness 140-255
+    CRGB c = base;
+    c.nscale8(boost);
+    // slight color variation
+    c.r = qadd8(c.r, effectState->rng.below(10));
+    c.g = qadd8(c.g, effectState->rng.below(10));
+    c.b = qadd8(c.b, effectState->rng.below(10));
+    strip[idx] = c;
   }
+}
+/**
+ * @brief Render one frame of the radial sweep effect - a beam rotating around the table centre
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderSweep(CRGB* strip, int count) {
+  effectState->phase += 2;
   
-  // Find the strongest known network
-  int bestNetworkIndex = -1;
-  int bestRSSI = -1000;
-  String bestSSID = "";
-  String bestPassword = "";
+  // Leave a fading trail behind the beam
+  fadeToBlackBy(strip, count, 40);
   
-  Serial.println("\n[WiFi] Checking for known networks...");
+  for (int i = 0; i < count; i++) {
+    // Angular distance behind the beam, wrapping naturally at 256
+    uint8_t behind = effectState->phase - pixelAt(i).angle;
+    if (behind < 24) {
+      uint8_t brightness = 255 - behind * 10;
+      strip[i] = CHSV(effectState->phase / 2 + 96, 200, brightness);
+    }
+  }
+}
+
+/**
+ * @brief Render one frame of the table sides effect - each edge in its own colour
+ * @param strip LED buffer to draw into
+ * @param count Number of LEDs in the buffer
+ */
+void renderSides(CRGB* strip, int count) {
+  effectState->phase++;
   
-  for (int i = 0; i < networkCount; i++) {
-    String scannedSSID = WiFi.SSID(i);
-    int scannedRSSI = WiFi.RSSI(i);
+  for (int i = 0; i < count; i++) {
+    const PixelCoord& p = pixelAt(i);
+    // Hue is fixed per side; a ripple runs along each edge from its start corner
+    uint8_t along = (p.side == SIDE_TOP || p.side == SIDE_BOTTOM) ? p.x : p.y;
+    uint8_t brightness = sin8(along * 2 - effectState->phase * 4);
+    strip[i] = CHSV(effectState->phase / 4 + p.side * 64, 255, qadd8(brightness / 2, 60));
+  }
+}
+
+/**
+ * @brief Compare each reduced resolution effect with rendering it at full resolution
+ * Both versions start from a black frame with the same phase and random seed,
+ * so the error figure is the mean per-channel difference the upscale causes.
+ * The effects run on a scratch state, so the running effect is untouched;
+ * the strip repaints on the next frame.
+ */
+void benchRender() {
+  struct ScaledEffect {
+    const char* name;
+    void (*render)(CRGB*, int);
+    int renderPixels;
+  };
+  const ScaledEffect effects[] = {
+    {"christmas", renderChristmas, CHRISTMAS_RENDER_PIXELS},
+    {"rainbow", renderRainbow, RAINBOW_RENDER_PIXELS},
+    {"candyCane", renderCandyCane, CANDYCANE_RENDER_PIXELS},
+    {"sweep", renderSweep, SWEEP_RENDER_PIXELS},
+    {"sides", renderSides, SIDES_RENDER_PIXELS}
+  };
+  const int iterations = 20;
+  EffectState* running = effectState;
+  EffectState scratch = EffectState();
+  effectState = &scratch;
+  
+  for (size_t e = 0; e < sizeof(effects) / sizeof(effects[0]); e++) {
+    const ScaledEffect& effect = effects[e];
+    int divisor = renderDivisor(effect.renderPixels, numLeds);
+    int lowCount = (numLeds + divisor - 1) / divisor;
+    scratch.startMs = millis();
     
-    // Check if this network is in our known list
-    for (int j = 0; j < numKnownNetworks; j++) {
-      if (scannedSSID.equals(knownNetworks[j].ssid)) {
-        Serial.printf("[WiFi] Found known network: %s (RSSI: %d dBm)\n", 
-                      scannedSSID.c_str(), scannedRSSI);
-        
-        if (scannedRSSI > bestRSSI) {
-          bestRSSI = scannedRSSI;
-          bestSSID = scannedSSID;
-          bestPassword = String(knownNetworks[j].password);
-          bestNetworkIndex = i;
-        }
-      }
+    // Full resolution into leds[]
+    unsigned long start = micros();
+    for (int n = 0; n < iterations; n++) {
+      scratch.phase = 0;
+      scratch.rng.seed(1234);
+      clearStrip();
+      effect.render(leds, numLeds);
+    }
+    unsigned long fullMicros = (micros() - start) / iterations;
+    
+    // Reduced resolution, upscaled into wireLeds[] so the two can be compared
+    start = micros();
+    for (int n = 0; n < iterations; n++) {
+      scratch.phase = 0;
+      scratch.rng.seed(1234);
+      fill_solid(lowResLeds, lowCount, CRGB::Black);
+      renderStride = divisor;
+      effect.render(lowResLeds, lowCount);
+      renderStride = 1;
+      upscaleLinear(lowResLeds, lowCount, wireLeds, numLeds, divisor);
+    }
+    unsigned long scaledMicros = (micros() - start) / iterations;
+    
+    uint32_t error = 0;
+    for (int i = 0; i < numLeds; i++) {
+      error += abs(leds[i].r - wireLeds[i].r) + abs(leds[i].g - wireLeds[i].g) +
+               abs(leds[i].b - wireLeds[i].b);
     }
+    
+    logMessageF("[Render] %s: %d px %lu us, %d px %lu us, mean error %u/255",
+                effect.name, numLeds, fullMicros, lowCount, scaledMicros,
+                (unsigned)(error / (numLeds * 3)));
   }
   
-  // Clean up scan results
-  WiFi.scanDelete();
+  effectState = running;
   
-  // Check if we found a known network
-  if (bestNetworkIndex == -1) {
-    Serial.println("[WiFi] ERROR: No known networks found!");
-    return false;
+  // Leave the wire buffer holding a valid frame again
+  uint32_t channelSums[3];
+  fusedOutput(leds, wireLeds, outputRemap, outputLut, numLeds, ledColorOrder, channelSums);
+}
+
+/**
+ * @brief Time the effect generator against FastLED's random8/random16
+ * Also checks that bounded draws are even by counting draws below 3 and
+ * below 300 (the strip length).
+ */
+void benchRandom() {
+  const int iterations = 10000;
+  volatile uint32_t sink = 0;
+  EffectRandom rng;
+  rng.seed(1234);
+  
+  unsigned long start = micros();
+  for (int n = 0; n < iterations; n++) {
+    sink += random8();
   }
+  unsigned long fastled8 = micros() - start;
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    sink += rng.next8();
+  }
+  unsigned long effect8 = micros() - start;
   
-  // Attempt to connect to the best network
-  Serial.printf("\n[WiFi] Connecting to strongest network: %s (RSSI: %d dBm)\n", 
-                bestSSID.c_str(), bestRSSI);
-  Serial.print("[WiFi] Connection progress: ");
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    sink += random16(numLeds);
+  }
+  unsigned long fastled16 = micros() - start;
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    sink += rng.below(numLeds);
+  }
+  unsigned long effect16 = micros() - start;
+  (void)sink;
   
-  WiFi.begin(bestSSID.c_str(), bestPassword.c_str());
+  // Spread of a small bounded draw
+  uint32_t buckets[3] = {0, 0, 0};
+  for (int n = 0; n < iterations; n++) {
+    buckets[rng.below(3)]++;
+  }
   
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
+  logMessageF("[Random] %d draws: random8 %lu us, next8 %lu us", iterations, fastled8, effect8);
+  logMessageF("[Random] %d draws: random16(%d) %lu us, below(%d) %lu us",
+              iterations, numLeds, fastled16, numLeds, effect16);
+  logMessageF("[Random] below(3) spread: %lu / %lu / %lu", buckets[0], buckets[1], buckets[2]);
+}
+
+/**
+ * @brief Thread that yields every frame, for timing the resume cost
+ */
+void benchYieldThread(EffectThread* t, volatile uint32_t* counter) {
+  EFFECT_BEGIN(t);
+  while (true) {
+    (*counter)++;
+    EFFECT_NEXT_FRAME(t);
+  }
+  EFFECT_END(t);
+}
+
+/**
+ * @brief Plain function doing the same work as benchYieldThread()
+ */
+void benchYieldPlain(volatile uint32_t* counter) {
+  (*counter)++;
+}
+
+/**
+ * @brief Measure what an effect thread costs per frame
+ * Compares resuming a thread with calling a plain function, then times the
+ * lightsaber duel scene as a whole.
+ */
+void benchThreads() {
+  const int iterations = 10000;
+  volatile uint32_t counter = 0;
+  EffectThread thread = {0, 0};
+  
+  unsigned long start = micros();
+  for (int n = 0; n < iterations; n++) {
+    benchYieldThread(&thread, &counter);
   }
+  unsigned long threadMicros = micros() - start;
   
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println(" SUCCESS!\n");
-    Serial.println("=================================");
-    Serial.println("[WiFi] CONNECTION ESTABLISHED");
-    Serial.println("=================================");
-    Serial.printf("SSID:        %s\n", WiFi.SSID().c_str());
-    Serial.printf("IP Address:  %s\n", WiFi.localIP().toString().c_str());
-    Serial.printf("MAC Address: %s\n", WiFi.macAddress().c_str());
-    Serial.printf("Signal:      %d dBm\n", WiFi.RSSI());
-    Serial.printf("Channel:     %d\n", WiFi.channel());
-    Serial.println("=================================\n");
-    return true;
-  } else {
-    Serial.println(" FAILED!");
-    Serial.printf("[WiFi] ERROR: Could not connect to %s\n", bestSSID.c_str());
-    return false;
+  start = micros();
+  for (int n = 0; n < iterations; n++) {
+    benchYieldPlain(&counter);
   }
+  unsigned long plainMicros = micros() - start;
+  
+  // Run the duel on its own frame, state and buffer so the running effect is
+  // left alone; the effect arena may already hold the live duel's frame
+  DuelFrame* duel = (DuelFrame*)calloc(1, sizeof(DuelFrame));
+  if (duel == NULL) {
+    logMessage("[Effects] Not enough memory for the benchmark duel frame");
+    return;
+  }
+  const int frames = 50;
+  EffectState* running = effectState;
+  EffectState scratch = EffectState();
+  scratch.rng.seed(1234);
+  effectState = &scratch;
+  start = micros();
+  for (int n = 0; n < frames; n++) {
+    duelThread(duel, numLeds);
+    drawDuel(duel, wireLeds, numLeds);
+  }
+  unsigned long duelMicros = (micros() - start) / frames;
+  effectState = running;
+  free(duel);
+  uint32_t channelSums[3];
+  fusedOutput(leds, wireLeds, outputRemap, outputLut, numLeds, ledColorOrder, channelSums);
+  
+  logMessageF("[Effects] %d resumes: thread %lu us, plain call %lu us (%lu ns extra per resume)",
+              iterations, threadMicros, plainMicros,
+              (threadMicros > plainMicros ? threadMicros - plainMicros : 0) * 1000 / iterations);
+  logMessageF("[Effects] Lightsaber duel: %lu us per frame for %d LEDs, frame %u bytes, arena %u/%u bytes used",
+              duelMicros, numLeds, (unsigned)sizeof(DuelFrame),
+              (unsigned)effectArena.used(), (unsigned)effectArena.capacity());
 }
 
 void setup() {
+  // Keep what the last boot left behind before anything overwrites it
+  beginBreadcrumbs();
+  
   // Initialize serial communication
   Serial.begin(115200);
   
@@ -1410,15 +5968,43 @@ void setup() {
   pinMode(LED_BUILTIN, OUTPUT);
   digitalWrite(LED_BUILTIN, LOW);
   
-  // Initialize FastLED for WS2812B LED strip
-  FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
-  FastLED.setBrightness(MAX_BRIGHTNESS);  // Reduced brightness to limit power draw
-  FastLED.setMaxPowerInVoltsAndMilliamps(5, 3500);  // Limit to 3.5A @ 5V (safe margin on 4A supply)
+  // Load strip geometry and allocate frame buffers before touching FastLED
+  loadStripConfig();
+  if (!allocateFrameBuffers()) {
+    Serial.printf("[LED Strip] ERROR: Could not allocate %u bytes for %d LEDs, using defaults\n",
+                  (unsigned)frameArenaBytes(numLeds), numLeds);
+    numLeds = DEFAULT_NUM_LEDS;
+    ledOutputs = 1;
+    ledOutputPins[0] = DEFAULT_LED_PIN;
+    allocateFrameBuffers();
+  }
+  effectArena.begin(EFFECT_ARENA_BYTES);
+  
+  // Compile the table layout into per-pixel coordinates
+  loadTableLayout();
+  
+  // Build the remap and gamma/brightness tables for the output stage
+  loadOutputConfig();
+  
+  // Asset storage
+  setupFilesystem();
+  
+  // Fleet group, and the health check if this is a freshly updated image
+  loadFleetConfig();
+  beginHealthCheck();
+  
+  // Initialize FastLED for the LED strip (one controller per output)
+  setupLedOutputs();
+  // Brightness and power limiting happen in the output stage (see showStrip()),
+  // so FastLED sends the wire buffer as-is
+  FastLED.setBrightness(255);
+  FastLED.setDither(DISABLE_DITHER);
   
   // Turn off all LEDs first
   turnOffAllLEDs();
   Serial.println("[LED Strip] WS2812B initialized");
-  Serial.printf("[LED Strip] GPIO: %d, Number of LEDs: %d\n", LED_PIN, NUM_LEDS);
+  Serial.printf("[LED Strip] GPIO: %d, Number of LEDs: %d, Outputs: %d\n", ledOutputPins[0], numLeds, ledOutputs);
+  Serial.printf("[Memory] Frame arena: %u bytes for %d LEDs\n", (unsigned)frameArena.capacity(), numLeds);
   
   Serial.println("[System] Setup initializing...");
   
@@ -1426,6 +6012,10 @@ void setup() {
   if (connectToStrongestKnownNetwork()) {
     // WiFi connection successful - now setup MQTT
     Serial.println("[System] Configuring MQTT client...");
+#if MQTT_USE_TLS
+    espClient.setCACert(MQTT_CA_CERT);
+    espClient.setMaxFragment(MQTT_TLS_MAX_FRAGMENT);
+#endif
     mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
     mqttClient.setCallback(mqttCallback);
     
@@ -1441,6 +6031,9 @@ void setup() {
     // Setup Web Server
     setupWebServer();
     
+    // Direct command port for controllers on the LAN
+    setupUdpCommands();
+    
     // Start LED status timer
     Serial.println("[System] Starting status LED timer...");
     
@@ -1472,9 +6065,25 @@ void setup() {
 }
 
 void loop() {
+  unsigned long loopStart = micros();
+  stageStartMicros = loopStart;     // The command stage was entered at the end of the last pass
+  receiveUdpCommands();
+  
   // Process pending commands (execute outside MQTT callback to avoid watchdog)
   if (pendingCommand != "") {
     Serial.printf("[MQTT] Executing pending command: %s\n", pendingCommand.c_str());
+    unsigned long waited = micros() - commandQueuedMicros;
+    commandsExecuted++;
+    commandRunMicros += waited;
+    if (waited > maxCommandRunMicros) {
+      maxCommandRunMicros = waited;
+    }
+    awaitingFrameMicros = commandQueuedMicros;
+    awaitingFrameUdp = pendingFromUdp;
+    awaitingUdp = pendingUdp;
+    pendingFromUdp = false;
+    strncpy(breadcrumbs.command, pendingCommand.c_str(), sizeof(breadcrumbs.command) - 1);
+    unsigned long effectChangesBefore = effectChanges;
     
     if (pendingCommand == "showStatus") {
       showStatus();
@@ -1482,6 +6091,48 @@ void loop() {
     else if (pendingCommand == "help") {
       showHelp();
     }
+    else if (pendingCommand == "showTiming") {
+      showTiming();
+    }
+    else if (pendingCommand == "showConfig") {
+      showConfig();
+    }
+    else if (pendingCommand == "benchOutput") {
+      benchOutput();
+    }
+    else if (pendingCommand == "commandStats") {
+      commandStats();
+    }
+    else if (pendingCommand == "loopStats") {
+      loopStats();
+    }
+    else if (pendingCommand == "webStats") {
+      showWebStats();
+      resetWebStats();
+    }
+    else if (pendingCommand == "benchRender") {
+      benchRender();
+    }
+    else if (pendingCommand == "benchNoise") {
+      benchNoise();
+    }
+    else if (pendingCommand == "benchThreads") {
+      benchThreads();
+    }
+    else if (pendingCommand == "benchRandom") {
+      benchRandom();
+    }
+    else if (pendingCommand == "benchFs") {
+      benchFs();
+    }
+    else if (pendingCommand == "reboot") {
+      logMessage("[System] Rebooting...");
+      delay(100);
+      ESP.restart();
+    }
+    else if (pendingCommand == "rollback") {
+      rollbackFirmware("manual");
+    }
     else if (pendingCommand == "allRed") {
       allRed();
     }
@@ -1560,14 +6211,48 @@ void loop() {
     else if (pendingCommand == "serene") {
       serene();
     }
+    else if (pendingCommand == "sweep") {
+      sweep();
+    }
+    else if (pendingCommand == "sides") {
+      sides();
+    }
     else if (pendingCommand == "setSpeed") {
       setSpeed(pendingCommandParam);
     }
     else if (pendingCommand == "setTrainSpeed") {
       setTrainSpeed(pendingCommandParam);
     }
+    else if (pendingCommand == "setStrip") {
+      setStripConfig(pendingCommandArg);
+    }
+    else if (pendingCommand == "setLayout") {
+      setTableLayout(pendingCommandArg);
+    }
+    else if (pendingCommand == "setGamma") {
+      setGamma(pendingCommandParam);
+    }
+    else if (pendingCommand == "setSeed") {
+      setSeed(pendingCommandParam);
+    }
+    else if (pendingCommand == "setRemap") {
+      setRemap(pendingCommandArg);
+    }
+    else if (pendingCommand == "pullUpdate") {
+      requestPullUpdate(pendingCommandArg);
+    }
+    else if (pendingCommand == "setGroup") {
+      setGroup(pendingCommandArg);
+    }
+    else if (pendingCommand == "fault") {
+      startFault(pendingCommandArg);
+    }
+    if (effectChanges != effectChangesBefore) {
+      currentEffect = pendingCommand;  // Named in the next state event
+    }
     pendingCommand = "";  // Clear the command
     pendingCommandParam = 0;
+    pendingCommandArg = "";
     
     Serial.println("[MQTT] Command execution complete");
   }
@@ -1578,8 +6263,17 @@ void loop() {
     unknownCommand = "";  // Clear after logging
   }
   
-  // Handle OTA updates
-  ArduinoOTA.handle();
+  // OTA uploads are received by the network task; follow their progress here
+  enterStage(STAGE_OTA);
+  updateOta();
+  updateHealthCheck();
+  
+  enterStage(STAGE_MQTT);
+  
+  // Injected latency: stall the network pass the way a slow socket does
+  if (activeFault == FAULT_LATENCY) {
+    delay(faultValue);
+  }
   
   // Maintain MQTT connection
   if (WiFi.status() == WL_CONNECTED) {
@@ -1589,6 +6283,7 @@ void loop() {
         // Only log once when connection is lost
         Serial.println("[MQTT] Connection lost. Attempting to reconnect...");
         loggedDisconnect = true;
+        mqttOfflineSince = millis();
       }
       mqttConnected = false;
       
@@ -1599,6 +6294,8 @@ void loop() {
         lastReconnectAttempt = now;
         if (connectToMQTT()) {
           loggedDisconnect = false;
+          mqttReconnects++;
+          mqttOfflineMs = millis() - mqttOfflineSince;
         }
       }
     } else {
@@ -1606,1122 +6303,237 @@ void loop() {
       mqttClient.loop();
     }
   } else {
+    enterStage(STAGE_WIFI);
     logMessage("[WiFi] Connection lost! Attempting to reconnect...");
     connectToStrongestKnownNetwork();
   }
   
   // Handle web server requests
+  enterStage(STAGE_WEB);
   webServer.handleClient();
   
+  enterStage(STAGE_HOUSEKEEPING);
+  updateFault();
+  updateBreadcrumbs();
+  reportLastReset();
+  reportMqttSession();
+  updateEvents();
+  publishStall();
+  
+  enterStage(STAGE_RENDER);
+  
   // Handle LED strip blinking
   if (blinkEnabled) {
     unsigned long now = millis();
-    if (now - lastBlinkTime >= blinkSpeed) {
-      lastBlinkTime = now;
-      blinkState = !blinkState;
-      
-      if (blinkState) {
-        // Turn all LEDs to the blink color
-        fill_solid(leds, NUM_LEDS, blinkColor);
-      } else {
-        // Turn all LEDs off
-        FastLED.clear();
-      }
-      FastLED.show();
+    if (now - effectState->lastUpdate >= blinkSpeed) {
+      effectState->lastUpdate = now;
+      renderBlink(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle twinkle effect
   if (twinkleEnabled) {
     unsigned long now = millis();
-    if (now - lastTwinkleUpdate >= TWINKLE_UPDATE_INTERVAL) {
-      lastTwinkleUpdate = now;
-      
-      // Update a few random LEDs each cycle for smooth, magical effect
-      for (int i = 0; i < TWINKLE_LEDS_PER_UPDATE; i++) {
-        int ledIndex = random16(NUM_LEDS);
-        
-        // Random decision: twinkle on, fade, or off
-        int action = random8(100);
-        
-        if (action < 15) {
-          // 15% chance: Light up with warm white/golden color
-          int brightness = random8(100, 255);
-          leds[ledIndex] = CRGB(brightness, brightness * 0.8, brightness * 0.3); // Warm golden
-        }
-        else if (action < 30) {
-          // 15% chance: Dim the LED
-          leds[ledIndex].fadeToBlackBy(64);
-        }
-        else if (action < 40) {
-          // 10% chance: Turn off completely
-          leds[ledIndex] = CRGB::Black;
-        }
-        // 60% chance: Do nothing (keep current state)
-      }
-      
-      // Fade all LEDs slightly for smooth transitions
-      fadeToBlackBy(leds, NUM_LEDS, 8);
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(TWINKLE_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderTwinkle(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle twinkle+ effect - MORE AGGRESSIVE TWINKLING!
   if (twinklePlusEnabled) {
     unsigned long now = millis();
-    if (now - lastTwinklePlusUpdate >= TWINKLEPLUS_UPDATE_INTERVAL) {
-      lastTwinklePlusUpdate = now;
-      
-      // Update many random LEDs each cycle for intense, aggressive effect
-      for (int i = 0; i < TWINKLEPLUS_LEDS_PER_UPDATE; i++) {
-        int ledIndex = random16(NUM_LEDS);
-        
-        // Random decision: twinkle on, fade, or off (more aggressive probabilities)
-        int action = random8(100);
-        
-        if (action < 30) {
-          // 30% chance: Light up with bright cool white sparkle
-          int brightness = random8(150, 255);  // Brighter minimum
-          leds[ledIndex] = CRGB(brightness, brightness, brightness); // Pure white sparkle
-        }
-        else if (action < 55) {
-          // 25% chance: Dim the LED dramatically
-          leds[ledIndex].fadeToBlackBy(100);  // More dramatic fade
-        }
-        else if (action < 70) {
-          // 15% chance: Turn off completely
-          leds[ledIndex] = CRGB::Black;
-        }
-        else if (action < 85) {
-          // 15% chance: Flash to maximum brightness with slight blue tint
-          leds[ledIndex] = CRGB(240, 245, 255);  // Bright cool white flash
-        }
-        // Only 15% chance: Do nothing (for more activity)
-      }
-      
-      // More aggressive fade for faster transitions
-      fadeToBlackBy(leds, NUM_LEDS, 15);  // Increased from 8 for faster changes
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(TWINKLEPLUS_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderTwinklePlus(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle gold effect - Shimmering gold twinkling
   if (goldEnabled) {
     unsigned long now = millis();
-    if (now - lastGoldUpdate >= GOLD_UPDATE_INTERVAL) {
-      lastGoldUpdate = now;
-      
-      // Update many random LEDs each cycle for twinkling gold effect
-      for (int i = 0; i < GOLD_LEDS_PER_UPDATE; i++) {
-        int ledIndex = random16(NUM_LEDS);
-        
-        // Random decision: brighten, dim, or maintain
-        int action = random8(100);
-        
-        if (action < 35) {
-          // 35% chance: Brighten to full gold
-          leds[ledIndex] = CRGB(255, 180, 0);  // Bright gold
-        }
-        else if (action < 60) {
-          // 25% chance: Medium gold
-          leds[ledIndex] = CRGB(200, 140, 0);  // Medium gold
-        }
-        else if (action < 75) {
-          // 15% chance: Dim gold
-          leds[ledIndex] = CRGB(150, 100, 0);  // Dim gold
-        }
-        else if (action < 85) {
-          // 10% chance: Very bright shimmer
-          leds[ledIndex] = CRGB(255, 215, 40);  // Bright shimmering gold
-        }
-        // 15% chance: Do nothing - maintain current state
-      }
-      
-      // Gentle fade to keep the gold color present
-      fadeToBlackBy(leds, NUM_LEDS, 8);  // Gentle fade
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(GOLD_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderGold(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Vegas effect - WILD AND CRAZY!
   if (vegasEnabled) {
     unsigned long now = millis();
-    if (now - lastVegasUpdate >= VEGAS_UPDATE_INTERVAL) {
-      lastVegasUpdate = now;
-      
-      // Increment hue for rainbow cycling
-      vegasHue += 4;
-      
-      // Choose random pattern each update
-      int pattern = random8(5);
-      
-      switch(pattern) {
-        case 0:
-          // Rainbow chase - section by section
-          for (int i = 0; i < NUM_LEDS; i++) {
-            leds[i] = CHSV(vegasHue + (i * 3), 255, 255);
-          }
-          break;
-          
-        case 1:
-          // Random color bursts
-          for (int i = 0; i < 20; i++) {
-            int ledIndex = random16(NUM_LEDS);
-            leds[ledIndex] = CHSV(random8(), 255, 255);
-          }
-          break;
-          
-        case 2:
-          // Sparkle madness
-          fadeToBlackBy(leds, NUM_LEDS, 30);
-          for (int i = 0; i < 30; i++) {
-            leds[random16(NUM_LEDS)] = CHSV(random8(), 200, 255);
-          }
-          break;
-          
-        case 3:
-          // Solid color flash (saturated colors)
-          fill_solid(leds, NUM_LEDS, CHSV(vegasHue, 255, 255));
-          break;
-          
-        case 4:
-          // Dual color strobe
-          for (int i = 0; i < NUM_LEDS; i++) {
-            if (i % 2 == 0) {
-              leds[i] = CHSV(vegasHue, 255, 255);
-            } else {
-              leds[i] = CHSV(vegasHue + 128, 255, 255);
-            }
-          }
-          break;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(VEGAS_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderVegas(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Valentines effect - Romantic pink and red love
   if (valentinesEnabled) {
     unsigned long now = millis();
-    if (now - lastValentinesUpdate >= VALENTINES_UPDATE_INTERVAL) {
-      lastValentinesUpdate = now;
-      
-      // Gentle pulsing hearts - alternating pink and red
-      uint8_t brightness = beatsin8(30, 50, 255);  // Slow breathing effect
-      for (int i = 0; i < NUM_LEDS; i++) {
-        if (i % 2 == 0) {
-          leds[i] = CRGB(brightness, 0, brightness / 3);  // Pink
-        } else {
-          leds[i] = CRGB(brightness, 0, 0);  // Red
-        }
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(VALENTINES_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderValentines(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle St. Patrick's effect - Irish green and gold luck
   if (stPatricksEnabled) {
     unsigned long now = millis();
-    if (now - lastStPatricksUpdate >= STPATRICKS_UPDATE_INTERVAL) {
-      lastStPatricksUpdate = now;
-      
-      stPatricksPhase++;
-      
-      // Choose Irish pattern based on phase
-      int pattern = (stPatricksPhase / 60) % 4;  // Pattern changes every ~2.7 seconds
-      
-      switch(pattern) {
-        case 0:
-          // Emerald wave - flowing green gradient
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t pos = (stPatricksPhase + i * 3) % 256;
-              if (pos < 128) {
-                // Bright green gradient
-                uint8_t brightness = 100 + pos;
-                leds[i] = CRGB(0, brightness, pos / 4);
-              } else {
-                // Dark green gradient
-                uint8_t brightness = 355 - pos;
-                leds[i] = CRGB(0, brightness, 20);
-              }
-            }
-          }
-          break;
-          
-        case 1:
-          // Leprechaun gold sparkles on green
-          {
-            // Base green layer
-            fadeToBlackBy(leds, NUM_LEDS, 3);
-            for (int i = 0; i < NUM_LEDS; i += 3) {
-              leds[i] = CRGB(0, 120, 20);  // Deep green
-            }
-            
-            // Random gold sparkles (pot of gold!)
-            for (int i = 0; i < 12; i++) {
-              int ledIndex = random16(NUM_LEDS);
-              leds[ledIndex] = CRGB(255, 180, 0);  // Gold
-            }
-          }
-          break;
-          
-        case 2:
-          // Shamrock shimmer - green with white luck sparkles
-          {
-            uint8_t brightness = beatsin8(25, 80, 200);  // Gentle breathing
-            for (int i = 0; i < NUM_LEDS; i++) {
-              leds[i] = CRGB(0, brightness, brightness / 5);
-            }
-            
-            // Lucky white sparkles
-            for (int i = 0; i < 8; i++) {
-              leds[random16(NUM_LEDS)] = CRGB(255, 255, 255);
-            }
-          }
-          break;
-          
-        case 3:
-          // Rainbow to pot of gold - green/gold alternating chase
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t pos = (stPatricksPhase * 2 + i * 5) % 256;
-              if (pos < 128) {
-                // Green
-                leds[i] = CRGB(0, 200 - pos, 30);
-              } else {
-                // Gold
-                pos = pos - 128;
-                leds[i] = CRGB(200 + pos / 2, 150 + pos / 3, 0);
-              }
-            }
-          }
-          break;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(STPATRICKS_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderStPatricks(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Halloween effect - Spooky orange, purple, and green
   if (halloweenEnabled) {
     unsigned long now = millis();
-    if (now - lastHalloweenUpdate >= HALLOWEEN_UPDATE_INTERVAL) {
-      lastHalloweenUpdate = now;
-      
-      halloweenPhase++;
-      
-      // Choose spooky pattern based on phase
-      int pattern = (halloweenPhase / 70) % 4;  // Pattern changes every ~2.5 seconds
-      
-      switch(pattern) {
-        case 0:
-          // Flickering jack-o-lantern - pulsing orange with random flickers
-          {
-            uint8_t baseBrightness = beatsin8(20, 100, 255);  // Slow pulse
-            
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t flicker = random8(3) == 0 ? random8(50, 100) : 0;  // Random flicker
-              uint8_t brightness = baseBrightness - flicker;
-              leds[i] = CRGB(brightness, brightness / 3, 0);  // Orange
-            }
-          }
-          break;
-          
-        case 1:
-          // Witch's cauldron - bubbling purple and green
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t pos = (halloweenPhase * 2 + i * 4) % 256;
-              if (pos < 128) {
-                // Purple
-                uint8_t brightness = 150 + (pos / 2);
-                leds[i] = CRGB(brightness / 2, 0, brightness);
-              } else {
-                // Eerie green
-                pos = pos - 128;
-                leds[i] = CRGB(0, 200 - pos, pos / 3);
-              }
-            }
-          }
-          break;
-          
-        case 2:
-          // Haunted house - random spooky colors appearing
-          {
-            fadeToBlackBy(leds, NUM_LEDS, 15);
-            
-            // Random spooky lights
-            for (int i = 0; i < 15; i++) {
-              int ledIndex = random16(NUM_LEDS);
-              int colorChoice = random8(3);
-              
-              if (colorChoice == 0) {
-                leds[ledIndex] = CRGB(255, 100, 0);   // Orange
-              } else if (colorChoice == 1) {
-                leds[ledIndex] = CRGB(128, 0, 200);   // Purple
-              } else {
-                leds[ledIndex] = CRGB(0, 255, 50);    // Eerie green
-              }
-            }
-          }
-          break;
-          
-        case 3:
-          // Ghostly apparition - floating white/green wisps
-          {
-            // Dark base
-            for (int i = 0; i < NUM_LEDS; i++) {
-              leds[i] = CRGB(10, 0, 20);  // Dark purple background
-            }
-            
-            // Ghostly wisps moving through
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t pos = (halloweenPhase * 3 + i * 8) % 256;
-              if (pos > 200 && pos < 240) {
-                // Ghostly white-green
-                uint8_t brightness = 255 - ((pos - 200) * 6);
-                leds[i] = CRGB(brightness / 2, brightness, brightness / 2);
-              }
-            }
-          }
-          break;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(HALLOWEEN_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderHalloween(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Christmas effect - Festive red, green, white, and gold
   if (christmasEnabled) {
     unsigned long now = millis();
-    if (now - lastChristmasUpdate >= CHRISTMAS_UPDATE_INTERVAL) {
-      lastChristmasUpdate = now;
-      
-      christmasPhase++;
-      
-      // Classic red and green waves
-      for (int i = 0; i < NUM_LEDS; i++) {
-        uint8_t pos = (christmasPhase * 2 + i * 3) % 256;
-        if (pos < 128) {
-          // Festive red
-          uint8_t brightness = 150 + pos;
-          leds[i] = CRGB(brightness, 0, 0);
-        } else {
-          // Christmas green
-          uint8_t brightness = 150 + (255 - pos);
-          leds[i] = CRGB(0, brightness, 0);
-        }
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(CHRISTMAS_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderScaled(renderChristmas, CHRISTMAS_RENDER_PIXELS);
+      showStrip();
     }
   }
   
   // Handle Birthday effect - Colorful celebration with confetti and candles
   if (birthdayEnabled) {
     unsigned long now = millis();
-    if (now - lastBirthdayUpdate >= BIRTHDAY_UPDATE_INTERVAL) {
-      lastBirthdayUpdate = now;
-      
-      birthdayPhase++;
-      
-      // Confetti burst - random colorful sparkles
-      fadeToBlackBy(leds, NUM_LEDS, 25);
-      
-      // Burst of colorful confetti
-      for (int i = 0; i < 25; i++) {
-        int ledIndex = random16(NUM_LEDS);
-        uint8_t hue = random8();  // Random rainbow colors
-        leds[ledIndex] = CHSV(hue, 255, 255);
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(BIRTHDAY_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderBirthday(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Wild Christmas effect - Fast chaotic Christmas party mode
   if (wildChristmasEnabled) {
     unsigned long now = millis();
-    if (now - lastWildChristmasUpdate >= WILDCHRISTMAS_UPDATE_INTERVAL) {
-      lastWildChristmasUpdate = now;
-      
-      wildChristmasPhase++;
-      
-      // Choose wild pattern based on phase
-      int pattern = (wildChristmasPhase / 90) % 4;  // Fast pattern changes every ~2.2 seconds
-      
-      switch(pattern) {
-        case 0:
-          // Crazy strobe - rapid red/green/white flashes
-          {
-            int flashPattern = wildChristmasPhase % 9;
-            CRGB color;
-            
-            if (flashPattern < 3) {
-              color = CRGB(255, 0, 0);     // Bright red
-            } else if (flashPattern < 6) {
-              color = CRGB(0, 255, 0);     // Bright green
-            } else {
-              color = CRGB(255, 255, 255); // White flash
-            }
-            
-            fill_solid(leds, NUM_LEDS, color);
-          }
-          break;
-          
-        case 1:
-          // Lightning bolts - random white strikes on Christmas colors
-          {
-            // Base alternating red/green
-            for (int i = 0; i < NUM_LEDS; i++) {
-              if ((i + wildChristmasPhase / 2) % 6 < 3) {
-                leds[i] = CRGB(150, 0, 0);   // Red
-              } else {
-                leds[i] = CRGB(0, 150, 0);   // Green
-              }
-            }
-            
-            // Random lightning strikes
-            if (random8() > 180) {
-              int strikePos = random16(NUM_LEDS);
-              int strikeLen = random8(20, 60);
-              for (int i = 0; i < strikeLen && (strikePos + i) < NUM_LEDS; i++) {
-                leds[strikePos + i] = CRGB(255, 255, 255);
-              }
-            }
-          }
-          break;
-          
-        case 2:
-          // Spinning Christmas chaos - fast rotating segments
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              int segment = ((i + wildChristmasPhase * 4) / 20) % 5;
-              
-              switch(segment) {
-                case 0:
-                  leds[i] = CRGB(255, 0, 0);      // Red
-                  break;
-                case 1:
-                  leds[i] = CRGB(0, 255, 0);      // Green
-                  break;
-                case 2:
-                  leds[i] = CRGB(255, 255, 255);  // White
-                  break;
-                case 3:
-                  leds[i] = CRGB(200, 150, 0);    // Gold
-                  break;
-                case 4:
-                  leds[i] = CRGB(0, 100, 200);    // Ice blue
-                  break;
-              }
-            }
-          }
-          break;
-          
-        case 3:
-          // Explosive sparkles - bursting Christmas colors everywhere
-          {
-            fadeToBlackBy(leds, NUM_LEDS, 40);
-            
-            // Massive sparkle explosions
-            for (int i = 0; i < 35; i++) {
-              int ledIndex = random16(NUM_LEDS);
-              int colorChoice = random8(5);
-              
-              CRGB sparkleColor;
-              switch(colorChoice) {
-                case 0:
-                  sparkleColor = CRGB(255, 0, 0);      // Red
-                  break;
-                case 1:
-                  sparkleColor = CRGB(0, 255, 0);      // Green
-                  break;
-                case 2:
-                  sparkleColor = CRGB(255, 255, 255);  // White
-                  break;
-                case 3:
-                  sparkleColor = CRGB(255, 200, 0);    // Gold
-                  break;
-                case 4:
-                  sparkleColor = CRGB(100, 200, 255);  // Ice blue
-                  break;
-              }
-              
-              leds[ledIndex] = sparkleColor;
-            }
-          }
-          break;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(WILDCHRISTMAS_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderWildChristmas(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Christmas Basic effect - Red, Green, White alternating with twinkling
   if (christmasBasicEnabled) {
     unsigned long now = millis();
-    if (now - lastChristmasBasicUpdate >= CHRISTMASBASIC_UPDATE_INTERVAL) {
-      lastChristmasBasicUpdate = now;
-      
-      // Update random LEDs for twinkling effect
-      for (int i = 0; i < 15; i++) {  // Update 15 random LEDs each cycle
-        int ledIndex = random16(NUM_LEDS);
-        
-        // Determine base color for this LED position
-        int colorIndex = ledIndex % 3;
-        CRGB baseColor;
-        if (colorIndex == 0) {
-          baseColor = CRGB::Red;
-        } else if (colorIndex == 1) {
-          baseColor = CRGB::Green;
-        } else {
-          baseColor = CRGB::White;
-        }
-        
-        // Random twinkle action
-        int action = random8(100);
-        
-        if (action < 20) {
-          // 20% chance: Brighten to full brightness (twinkle on)
-          leds[ledIndex] = baseColor;
-        }
-        else if (action < 40) {
-          // 20% chance: Dim the LED noticeably
-          leds[ledIndex] = baseColor;
-          leds[ledIndex].fadeToBlackBy(100);  // Dim to about 60% brightness
-        }
-        else if (action < 50) {
-          // 10% chance: Very dim (almost off but noticeable)
-          leds[ledIndex] = baseColor;
-          leds[ledIndex].fadeToBlackBy(200);  // Dim to about 22% brightness
-        }
-        // 50% chance: Do nothing - maintain current state for persistence
-      }
-      
-      // Gentle overall fade to create breathing/twinkling effect
-      fadeToBlackBy(leds, NUM_LEDS, 3);  // Very subtle fade
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(CHRISTMASBASIC_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderChristmasBasic(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Christmas Train effect - Rotating red, green, white pattern
   if (christmasTrainEnabled) {
     unsigned long now = millis();
-    if (now - lastChristmasTrainUpdate >= christmasTrainSpeed) {
-      lastChristmasTrainUpdate = now;
-      
-      // Increment offset to create rotation effect
-      christmasTrainOffset++;
-      if (christmasTrainOffset >= 3) {
-        christmasTrainOffset = 0;  // Reset after full color cycle
-      }
-      
-      // Update all LEDs with rotated pattern
-      for (int i = 0; i < NUM_LEDS; i++) {
-        int colorIndex = (i + christmasTrainOffset) % 3;
-        if (colorIndex == 0) {
-          leds[i] = CRGB::Red;
-        } else if (colorIndex == 1) {
-          leds[i] = CRGB::Green;
-        } else {
-          leds[i] = CRGB::White;
-        }
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= christmasTrainSpeed) {
+      effectState->lastUpdate = now;
+      renderChristmasTrain(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Rainbow effect - Smooth spectrum animations
   if (rainbowEnabled) {
     unsigned long now = millis();
-    if (now - lastRainbowUpdate >= RAINBOW_UPDATE_INTERVAL) {
-      lastRainbowUpdate = now;
-      
-      rainbowPhase++;
-      
-      // Choose rainbow pattern based on phase
-      int pattern = (rainbowPhase / 80) % 4;  // Pattern changes every ~2.4 seconds
-      
-      switch(pattern) {
-        case 0:
-          // Classic flowing rainbow wave
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t hue = (rainbowPhase * 2 + i * 2) % 256;
-              leds[i] = CHSV(hue, 255, 255);
-            }
-          }
-          break;
-          
-        case 1:
-          // Rainbow pulse - breathing full spectrum
-          {
-            uint8_t brightness = beatsin8(20, 100, 255);
-            
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t hue = (i * 3) % 256;
-              leds[i] = CHSV(hue, 255, brightness);
-            }
-          }
-          break;
-          
-        case 2:
-          // Rainbow segments - distinct color blocks moving
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t segment = ((i + rainbowPhase * 2) / 30) % 7;
-              uint8_t hue = segment * 36;  // 7 colors evenly spaced around hue wheel
-              leds[i] = CHSV(hue, 255, 255);
-            }
-          }
-          break;
-          
-        case 3:
-          // Rainbow sparkle - twinkling multi-color
-          {
-            fadeToBlackBy(leds, NUM_LEDS, 15);
-            
-            // Add rainbow sparkles
-            for (int i = 0; i < 20; i++) {
-              int ledIndex = random16(NUM_LEDS);
-              uint8_t hue = random8();
-              leds[ledIndex] = CHSV(hue, 255, 255);
-            }
-          }
-          break;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(RAINBOW_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderScaled(renderRainbow, RAINBOW_RENDER_PIXELS);
+      showStrip();
     }
   }
   
   // Handle May The 4th effect - Star Wars themed animations
   if (mayThe4thEnabled) {
     unsigned long now = millis();
-    if (now - lastMayThe4thUpdate >= MAYTHE4TH_UPDATE_INTERVAL) {
-      lastMayThe4thUpdate = now;
-      
-      mayThe4thPhase++;
-      
-      // Choose Star Wars pattern based on phase
-      int pattern = (mayThe4thPhase / 75) % 4;  // Pattern changes every ~2.6 seconds
-      
-      switch(pattern) {
-        case 0:
-          // Lightsaber duel - blue vs red clashing
-          {
-            int duelPosition = (mayThe4thPhase * 4) % NUM_LEDS;
-            
-            for (int i = 0; i < NUM_LEDS; i++) {
-              if (i < duelPosition) {
-                // Blue lightsaber (Jedi)
-                int distance = abs(i - duelPosition);
-                if (distance < 30) {
-                  uint8_t brightness = 255 - (distance * 8);
-                  leds[i] = CRGB(brightness / 4, brightness / 4, brightness);
-                } else {
-                  leds[i] = CRGB(0, 0, 0);
-                }
-              } else {
-                // Red lightsaber (Sith)
-                int distance = abs(i - duelPosition);
-                if (distance < 30) {
-                  uint8_t brightness = 255 - (distance * 8);
-                  leds[i] = CRGB(brightness, brightness / 8, brightness / 8);
-                } else {
-                  leds[i] = CRGB(0, 0, 0);
-                }
-              }
-            }
-            
-            // Clash point - white flash
-            for (int i = -3; i <= 3; i++) {
-              int pos = duelPosition + i;
-              if (pos >= 0 && pos < NUM_LEDS) {
-                leds[pos] = CRGB(255, 255, 255);
-              }
-            }
-          }
-          break;
-          
-        case 1:
-          // Hyperspace jump - streaking blue and white
-          {
-            fadeToBlackBy(leds, NUM_LEDS, 50);
-            
-            // Create hyperspace streaks
-            for (int i = 0; i < 15; i++) {
-              int streakStart = (mayThe4thPhase * 6 + i * 60) % NUM_LEDS;
-              int streakLength = 20;
-              
-              for (int j = 0; j < streakLength; j++) {
-                int pos = (streakStart + j) % NUM_LEDS;
-                uint8_t brightness = 255 - (j * 12);
-                if (i % 2 == 0) {
-                  leds[pos] = CRGB(brightness / 2, brightness / 2, brightness);  // Blue streak
-                } else {
-                  leds[pos] = CRGB(brightness, brightness, brightness);  // White streak
-                }
-              }
-            }
-          }
-          break;
-          
-        case 2:
-          // Death Star tractor beam - pulsing green beams
-          {
-            // Space background
-            for (int i = 0; i < NUM_LEDS; i++) {
-              leds[i] = CRGB(2, 2, 5);  // Dark space
-            }
-            
-            // Starfield twinkle
-            if (random8() > 200) {
-              int star = random16(NUM_LEDS);
-              leds[star] = CRGB(255, 255, 255);
-            }
-            
-            // Pulsing green tractor beams
-            uint8_t beamBrightness = beatsin8(25, 50, 255);
-            for (int i = 0; i < NUM_LEDS; i += 50) {
-              int beamCenter = (i + mayThe4thPhase) % NUM_LEDS;
-              
-              for (int j = -8; j <= 8; j++) {
-                int pos = beamCenter + j;
-                if (pos >= 0 && pos < NUM_LEDS) {
-                  uint8_t brightness = beamBrightness - (abs(j) * 15);
-                  leds[pos] = CRGB(0, brightness, brightness / 3);
-                }
-              }
-            }
-          }
-          break;
-          
-        case 3:
-          // Force energy - alternating Jedi blue/green and Sith red
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t wave = sin8((mayThe4thPhase * 2 + i * 4) % 256);
-              
-              if (wave < 128) {
-                // Light side - blue/green Force energy
-                uint8_t brightness = wave * 2;
-                if (i % 2 == 0) {
-                  leds[i] = CRGB(brightness / 4, brightness / 2, brightness);  // Blue
-                } else {
-                  leds[i] = CRGB(brightness / 4, brightness, brightness / 4);  // Green
-                }
-              } else {
-                // Dark side - red Force lightning
-                uint8_t brightness = (255 - wave) * 2;
-                leds[i] = CRGB(brightness, brightness / 8, 0);
-              }
-            }
-          }
-          break;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(MAYTHE4TH_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderMayThe4th(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Canada Day effect - Red and white patriotic Canadian celebration
   if (canadaDayEnabled) {
     unsigned long now = millis();
-    if (now - lastCanadaDayUpdate >= CANADADAY_UPDATE_INTERVAL) {
-      lastCanadaDayUpdate = now;
-      
-      canadaDayPhase++;
-      
-      // Choose Canadian pattern based on phase
-      int pattern = (canadaDayPhase / 70) % 4;  // Pattern changes every ~2.8 seconds
-      
-      switch(pattern) {
-        case 0:
-          // Maple leaf stripes - alternating red and white bands
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t pos = (canadaDayPhase + i * 5) % 100;
-              if (pos < 50) {
-                // Canadian red
-                leds[i] = CRGB(255, 0, 0);
-              } else {
-                // Pure white
-                leds[i] = CRGB(255, 255, 255);
-              }
-            }
-          }
-          break;
-          
-        case 1:
-          // Northern lights shimmer - red and white aurora
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t wave1 = sin8((canadaDayPhase * 2 + i * 3) % 256);
-              uint8_t wave2 = sin8((canadaDayPhase * 3 + i * 2) % 256);
-              
-              if (wave1 > wave2) {
-                // Red shimmer
-                uint8_t brightness = (wave1 + wave2) / 2;
-                leds[i] = CRGB(brightness, brightness / 8, brightness / 8);
-              } else {
-                // White shimmer
-                uint8_t brightness = (wave1 + wave2) / 2;
-                leds[i] = CRGB(brightness, brightness, brightness);
-              }
-            }
-          }
-          break;
-          
-        case 2:
-          // Fireworks burst - red and white explosions
-          {
-            fadeToBlackBy(leds, NUM_LEDS, 20);
-            
-            // Create firework bursts
-            if (canadaDayPhase % 15 == 0) {
-              int burstCenter = random16(NUM_LEDS);
-              bool isRed = random8() > 127;
-              
-              // Burst pattern
-              for (int i = -20; i <= 20; i++) {
-                int pos = burstCenter + i;
-                if (pos >= 0 && pos < NUM_LEDS) {
-                  uint8_t brightness = 255 - (abs(i) * 10);
-                  if (isRed) {
-                    leds[pos] = CRGB(brightness, 0, 0);
-                  } else {
-                    leds[pos] = CRGB(brightness, brightness, brightness);
-                  }
-                }
-              }
-            }
-            
-            // Sparkles
-            for (int i = 0; i < 15; i++) {
-              int ledIndex = random16(NUM_LEDS);
-              if (random8() > 127) {
-                leds[ledIndex] = CRGB(255, 0, 0);        // Red sparkle
-              } else {
-                leds[ledIndex] = CRGB(255, 255, 255);    // White sparkle
-              }
-            }
-          }
-          break;
-          
-        case 3:
-          // Flag wave - flowing red/white/red pattern
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              // Create three sections like the Canadian flag
-              uint8_t section = ((i + canadaDayPhase * 2) * 3 / NUM_LEDS);
-              uint8_t wave = beatsin8(20, 150, 255, 0, i * 2);
-              
-              if (section == 0 || section == 2) {
-                // Red sections (left and right of flag)
-                leds[i] = CRGB(wave, 0, 0);
-              } else {
-                // White center section (where maple leaf would be)
-                // Add slight red tint for maple leaf suggestion
-                uint8_t maple = sin8((canadaDayPhase * 4 + i * 8) % 256);
-                if (maple > 200) {
-                  leds[i] = CRGB(wave, wave / 4, wave / 4);  // Red maple highlight
-                } else {
-                  leds[i] = CRGB(wave, wave, wave);  // White background
-                }
-              }
-            }
-          }
-          break;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(CANADADAY_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderCanadaDay(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle New Years effect - Gold, silver, and colorful celebration
   if (newYearsEnabled) {
     unsigned long now = millis();
-    if (now - lastNewYearsUpdate >= NEWYEARS_UPDATE_INTERVAL) {
-      lastNewYearsUpdate = now;
-      
-      newYearsPhase++;
-      
-      // Choose celebration pattern based on phase
-      int pattern = (newYearsPhase / 75) % 4;  // Pattern changes every ~2.6 seconds
-      
-      switch(pattern) {
-        case 0:
-          // Champagne bubbles - rising gold and silver sparkles
-          {
-            fadeToBlackBy(leds, NUM_LEDS, 20);
-            
-            // Rising bubbles effect
-            for (int i = 0; i < 30; i++) {
-              int ledIndex = random16(NUM_LEDS);
-              bool isGold = random8() > 127;
-              
-              if (isGold) {
-                leds[ledIndex] = CRGB(255, 200, 0);      // Gold bubble
-              } else {
-                leds[ledIndex] = CRGB(220, 220, 255);    // Silver/white bubble
-              }
-            }
-          }
-          break;
-          
-        case 1:
-          // Countdown sparkle - alternating gold and silver waves
-          {
-            for (int i = 0; i < NUM_LEDS; i++) {
-              uint8_t pos = (newYearsPhase * 3 + i * 2) % 256;
-              if (pos < 128) {
-                // Gold wave
-                uint8_t brightness = 150 + pos;
-                leds[i] = CRGB(brightness, brightness * 0.7, 0);
-              } else {
-                // Silver wave
-                uint8_t brightness = 150 + (255 - pos);
-                leds[i] = CRGB(brightness * 0.8, brightness * 0.8, brightness);
-              }
-            }
-          }
-          break;
-          
-        case 2:
-          // Fireworks burst - colorful explosions
-          {
-            fadeToBlackBy(leds, NUM_LEDS, 15);
-            
-            // Create firework bursts
-            if (newYearsPhase % 12 == 0) {
-              int burstCenter = random16(NUM_LEDS);
-              uint8_t hue = random8();  // Random color
-              
-              // Burst pattern
-              for (int i = -25; i <= 25; i++) {
-                int pos = burstCenter + i;
-                if (pos >= 0 && pos < NUM_LEDS) {
-                  uint8_t brightness = 255 - (abs(i) * 8);
-                  leds[pos] = CHSV(hue, 255, brightness);
-                }
-              }
-            }
-            
-            // Add sparkles
-            for (int i = 0; i < 20; i++) {
-              int ledIndex = random16(NUM_LEDS);
-              uint8_t sparkleHue = random8();
-              leds[ledIndex] = CHSV(sparkleHue, 255, 255);
-            }
-          }
-          break;
-          
-        case 3:
-          // Confetti celebration - rapid multicolor bursts
-          {
-            fadeToBlackBy(leds, NUM_LEDS, 30);
-            
-            // Intense confetti burst
-            for (int i = 0; i < 35; i++) {
-              int ledIndex = random16(NUM_LEDS);
-              uint8_t colorChoice = random8(5);
-              
-              switch(colorChoice) {
-                case 0:
-                  leds[ledIndex] = CRGB(255, 200, 0);    // Gold
-                  break;
-                case 1:
-                  leds[ledIndex] = CRGB(220, 220, 255);  // Silver
-                  break;
-                case 2:
-                  leds[ledIndex] = CRGB(255, 0, 100);    // Pink
-                  break;
-                case 3:
-                  leds[ledIndex] = CRGB(0, 200, 255);    // Cyan
-                  break;
-                case 4:
-                  leds[ledIndex] = CRGB(150, 0, 255);    // Purple
-                  break;
-              }
-            }
-          }
-          break;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(NEWYEARS_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderNewYears(leds, numLeds);
+      showStrip();
     }
   }
   
   // Handle Candy Cane effect - Red and white stripes
   if (candyCaneEnabled) {
     unsigned long now = millis();
-    if (now - lastCandyCaneUpdate >= CANDYCANE_UPDATE_INTERVAL) {
-      lastCandyCaneUpdate = now;
-      
-      candyCanePhase++;
-      
-      // Candy cane stripes - red and white
-      for (int i = 0; i < NUM_LEDS; i++) {
-        uint8_t pos = (candyCanePhase + i * 10) % 80;
-        if (pos < 40) {
-          // Bright red stripe
-          leds[i] = CRGB(255, 0, 0);
-        } else {
-          // Pure white stripe
-          leds[i] = CRGB(255, 255, 255);
-        }
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(CANDYCANE_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderScaled(renderCandyCane, CANDYCANE_RENDER_PIXELS);
+      showStrip();
+    }
+  }
+  
+  // Handle radial sweep effect - Beam rotating around the table
+  if (sweepEnabled) {
+    unsigned long now = millis();
+    if (now - effectState->lastUpdate >= shedInterval(SWEEP_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderScaled(renderSweep, SWEEP_RENDER_PIXELS);
+      showStrip();
+    }
+  }
+  
+  // Handle table sides effect - Each edge in its own colour
+  if (sidesEnabled) {
+    unsigned long now = millis();
+    if (now - effectState->lastUpdate >= shedInterval(SIDES_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderScaled(renderSides, SIDES_RENDER_PIXELS);
+      showStrip();
     }
   }
   
   // Handle Serene effect - Gentle Christmas palette sparkles
   if (sereneEnabled) {
     unsigned long now = millis();
-    if (now - lastSereneUpdate >= SERENE_UPDATE_INTERVAL) {
-      lastSereneUpdate = now;
-      
-      // Gentle global fade - keep a soft tail
-      for (int i = 0; i < NUM_LEDS; i++) {
-        leds[i].nscale8(230);
-      }
-      
-      // Christmas palette seeds: warm white, soft red, soft green, gold
-      const CRGB palette[] = {
-        CRGB(255, 240, 200), // warm white
-        CRGB(200, 30, 30),   // soft red
-        CRGB(20, 160, 40),   // soft green
-        CRGB(230, 180, 40)   // gold
-      };
-      
-      // Seed a few random pixels
-      uint8_t seeds = 3 + random8(3); // 3-5 sparks per frame
-      for (uint8_t s = 0; s < seeds; s++) {
-        int idx = random16(NUM_LEDS);
-        CRGB base = palette[random8(sizeof(palette) / sizeof(palette[0]))];
-        uint8_t boost = 140 + random8(115); // brightness 140-255
-        CRGB c = base;
-        c.nscale8(boost);
-        // slight color variation
-        c.r = qadd8(c.r, random8(10));
-        c.g = qadd8(c.g, random8(10));
-        c.b = qadd8(c.b, random8(10));
-        leds[idx] = c;
-      }
-      
-      FastLED.show();
+    if (now - effectState->lastUpdate >= shedInterval(SERENE_UPDATE_INTERVAL)) {
+      effectState->lastUpdate = now;
+      renderSerene(leds, numLeds);
+      showStrip();
     }
   }
   
-  delay(100);
+  // Charge the render stage now; the next pass starts from here
+  enterStage(STAGE_COMMAND);
+  updateLoadShedding(micros() - loopStart);
+  delay(LOOP_IDLE_MS);
 }
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+
+###############################################################################
+# UDP Command Sender for ESP32 India Table Project
+#
+# Usage: ./udp-command.py <IP_ADDRESS> <COMMAND> [--count N] [--interval MS]
+# Example: ./udp-command.py 192.168.2.100 rainbow
+#          ./udp-command.py 192.168.2.100 rainbow,sweep,sides --count 200
+#
+# Sends commands straight to the table's UDP command port, skipping the
+# MQTT broker. Each packet is signed with an HMAC-SHA256 keyed with the OTA
+# password and carries a sequence number (microseconds since the epoch), so
+# the table refuses forged and replayed packets. For each command it prints
+# the round trip to the table's "ok" and the time from the packet arriving
+# to the first frame on the strip, as measured by the table. With --count
+# the commands are cycled and percentiles are printed at the end.
+###############################################################################
+
+import argparse
+import hashlib
+import hmac
+import os
+import socket
+import sys
+import time
+
+# Color codes for output
+RED = "\033[0;31m"
+GREEN = "\033[0;32m"
+YELLOW = "\033[1;33m"
+NC = "\033[0m"  # No Color
+
+UDP_PORT = 4210
+DEFAULT_KEY = "ChristmasTree2025!"
+
+
+def send(sock, address, key, command, timeout):
+    """Send one command. Returns (reply, round trip ms, packet-to-frame us or None)."""
+    body = f"{time.time_ns() // 1000} {command}"
+    mac = hmac.new(key.encode(), body.encode(), hashlib.sha256).hexdigest()
+    start = time.perf_counter()
+    sock.sendto(f"{body} {mac}".encode(), address)
+
+    sock.settimeout(timeout)
+    try:
+        reply = sock.recv(64).decode()
+    except socket.timeout:
+        return "timeout", None, None
+    round_trip = (time.perf_counter() - start) * 1000
+    if not reply.startswith("ok"):
+        return reply, round_trip, None
+
+    # The table answers again when the first frame after the command is shown,
+    # or with an error if it does not know the command
+    try:
+        second = sock.recv(64).decode()
+    except socket.timeout:
+        return reply, round_trip, None
+    if second.startswith("err"):
+        return second, round_trip, None
+    shown = second.split()
+    frame_us = int(shown[2]) if len(shown) == 3 and shown[0] == "shown" else None
+    return reply, round_trip, frame_us
+
+
+def percentiles(values):
+    values = sorted(values)
+    pick = lambda p: values[int((len(values) - 1) * p)]
+    return f"p50 {pick(0.50):.1f}  p90 {pick(0.90):.1f}  p99 {pick(0.99):.1f}  max {values[-1]:.1f}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Send commands to the India Table over UDP")
+    parser.add_argument("ip", help="table IP address")
+    parser.add_argument("command", help="command, or a comma-separated list to cycle through")
+    parser.add_argument("--count", type=int, default=1, help="commands to send")
+    parser.add_argument("--interval", type=int, default=100, help="ms between commands")
+    parser.add_argument("--key", default=os.environ.get("OTA_PASSWORD", DEFAULT_KEY), help="OTA password (signing key)")
+    args = parser.parse_args()
+
+    commands = args.command.split(",")
+    address = (args.ip, UDP_PORT)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+
+    if args.count > 1:
+        print(f"{GREEN}╔════════════════════════════════════════════╗{NC}")
+        print(f"{GREEN}║  ESP32 India Table UDP Command Test       ║{NC}")
+        print(f"{GREEN}╚════════════════════════════════════════════╝{NC}")
+        print()
+        print(f"{YELLOW}Target:{NC} {args.ip}:{UDP_PORT}")
+        print(f"{YELLOW}Commands:{NC} {args.count}, {args.interval} ms apart")
+        print()
+
+    round_trips = []
+    frames = []
+    failures = 0
+    for i in range(args.count):
+        command = commands[i % len(commands)]
+        reply, round_trip, frame_us = send(sock, address, args.key, command, 1.0)
+        if round_trip is None or not reply.startswith("ok"):
+            failures += 1
+            print(f"{RED}{command}: {reply}{NC}")
+        else:
+            round_trips.append(round_trip)
+            if frame_us is not None:
+                frames.append(frame_us / 1000)
+            if args.count == 1:
+                shown = f", on the strip {frame_us / 1000:.1f} ms after arrival" if frame_us is not None else ""
+                print(f"{GREEN}{command}: {reply}{NC} (round trip {round_trip:.1f} ms{shown})")
+        time.sleep(args.interval / 1000)
+
+    if args.count > 1:
+        print(f"Sent {args.count}, {failures} failed")
+        if round_trips:
+            print(f"Round trip to ok (ms):      {percentiles(round_trips)}")
+        if frames:
+            print(f"Packet to frame (ms):       {percentiles(frames)}")
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
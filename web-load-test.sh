@@ -0,0 +1,82 @@
+#!/bin/bash
+
+###############################################################################
+# Web Server Load Test for ESP32 India Table Project
+#
+# Usage: ./web-load-test.sh <IP_ADDRESS> [REQUESTS] [CONCURRENCY]
+# Example: ./web-load-test.sh 192.168.2.100 200 4
+#
+# Sends REQUESTS requests to each of /, /cmd and /favicon.ico with
+# CONCURRENCY requests in flight, and prints requests/s and latency
+# percentiles as seen from this machine. It then prints the table's own
+# per-handler figures from /stats (handler time and heap use per request).
+# The /cmd requests send an unknown command (answered with 400), so the
+# running effect is not changed. Needs curl.
+###############################################################################
+
+# Color codes for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+# Check if IP address argument is provided
+if [ -z "$1" ]; then
+    echo -e "${RED}ERROR: No IP address provided${NC}"
+    echo ""
+    echo "Usage: $0 <IP_ADDRESS> [REQUESTS] [CONCURRENCY]"
+    echo "Example: $0 192.168.2.100 200 4"
+    exit 1
+fi
+
+IP_ADDRESS=$1
+REQUESTS=${2:-100}
+CONCURRENCY=${3:-1}
+
+# Print requests/s and latency percentiles for one route
+# $1 = path, $2 = file of per-request times in seconds, $3 = wall time in ms
+report() {
+    local path=$1
+    local times=$2
+    local wall_ms=$3
+    sort -n "$times" | awk -v path="$path" -v wall="$wall_ms" '
+        { t[NR] = $1 * 1000; sum += $1 * 1000 }
+        END {
+            if (NR == 0) { printf "%-14s no responses\n", path; exit }
+            p50 = t[int((NR - 1) * 0.50) + 1]
+            p90 = t[int((NR - 1) * 0.90) + 1]
+            p99 = t[int((NR - 1) * 0.99) + 1]
+            printf "%-14s %5d requests  %6.1f req/s  avg %6.1f ms  p50 %6.1f  p90 %6.1f  p99 %6.1f  max %6.1f ms\n",
+                   path, NR, NR * 1000 / wall, sum / NR, p50, p90, p99, t[NR]
+        }'
+}
+
+echo -e "${GREEN}╔════════════════════════════════════════════╗${NC}"
+echo -e "${GREEN}║  ESP32 India Table Web Load Test          ║${NC}"
+echo -e "${GREEN}╚════════════════════════════════════════════╝${NC}"
+echo ""
+echo -e "${YELLOW}Target IP:${NC} $IP_ADDRESS"
+echo -e "${YELLOW}Requests:${NC} $REQUESTS per route, $CONCURRENCY at a time"
+echo ""
+
+# Start a fresh measurement window on the table
+if ! curl -s -f -m 5 "http://$IP_ADDRESS/stats?reset=1" > /dev/null; then
+    echo -e "${RED}ERROR: No response from http://$IP_ADDRESS/stats${NC}"
+    exit 1
+fi
+
+TIMES=$(mktemp)
+trap 'rm -f "$TIMES"' EXIT
+
+for path in "/" "/cmd?command=loadTest" "/favicon.ico"; do
+    : > "$TIMES"
+    START_NS=$(date +%s%N)
+    seq "$REQUESTS" | xargs -P "$CONCURRENCY" -I{} \
+        curl -s -o /dev/null -m 10 -w "%{time_total}\n" "http://$IP_ADDRESS$path" >> "$TIMES"
+    END_NS=$(date +%s%N)
+    report "${path%%\?*}" "$TIMES" $(( (END_NS - START_NS) / 1000000 ))
+done
+
+echo ""
+echo "Handler figures from the table:"
+curl -s -m 5 "http://$IP_ADDRESS/stats"